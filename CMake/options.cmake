@@ -344,6 +344,7 @@ if(UNIX)
     unset(FLTK_USE_XFT CACHE)
     unset(FLTK_USE_XCURSOR CACHE)
     unset(FLTK_USE_XFIXES CACHE)
+    unset(FLTK_USE_XSHM CACHE)
     if(X11_FOUND)
       if(NOT X11_Xfixes_FOUND)
         message(WARNING "Install development headers for libXfixes (e.g., libxfixes-dev)")
@@ -458,6 +459,13 @@ if(FLTK_USE_POLL)
   check_symbol_exists(poll   "poll.h"   USE_POLL)
 endif(FLTK_USE_POLL)
 
+option(FLTK_USE_EPOLL "use epoll on Linux if available" OFF)
+mark_as_advanced(FLTK_USE_EPOLL)
+
+if(FLTK_USE_EPOLL)
+  check_symbol_exists(epoll_create1 "sys/epoll.h" USE_EPOLL)
+endif(FLTK_USE_EPOLL)
+
 #######################################################################
 option(FLTK_BUILD_SHARED_LIBS
   "Build shared libraries in addition to static libraries"
@@ -1031,6 +1039,19 @@ else(FLTK_USE_XRENDER)
   set(FLTK_XRENDER_FOUND FALSE)
 endif(FLTK_USE_XRENDER)
 
+#######################################################################
+if(X11_XShm_FOUND AND X11_Xext_FOUND)
+  option(FLTK_USE_XSHM "use the MIT-SHM extension to draw images" OFF)
+endif(X11_XShm_FOUND AND X11_Xext_FOUND)
+
+if(FLTK_USE_XSHM)
+  set(HAVE_XSHM ${X11_XShm_FOUND})
+  list(APPEND FLTK_BUILD_INCLUDE_DIRECTORIES ${X11_XShm_INCLUDE_PATH})
+  set(FLTK_XSHM_FOUND TRUE)
+else()
+  set(FLTK_XSHM_FOUND FALSE)
+endif(FLTK_USE_XSHM)
+
 #######################################################################
 set(FL_NO_PRINT_SUPPORT FALSE)
 if(X11_FOUND AND NOT FLTK_OPTION_PRINT_SUPPORT)
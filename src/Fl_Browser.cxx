@@ -28,9 +28,10 @@
 
 // I modified this from the original Forms data to use a linked list
 // so that the number of items in the browser and size of those items
-// is unlimited. The only problem is that the old browser used an
-// index number to identify a line, and it is slow to convert from/to
-// a pointer. I use a cache of the last match to try to speed this up.
+// is unlimited. The old browser used an index number to identify a
+// line, so the lines are also kept in a balanced tree (a treap ordered
+// by line number) that converts from/to a pointer in O(log n) time and
+// sums up the heights of the lines before a line.
 
 // Also added the ability to "hide" a line. This sets its height to
 // zero, so the Fl_Browser_ cannot pick it.
@@ -38,6 +39,13 @@
 struct FL_BLINE {       // data is in a linked list of these
   FL_BLINE* prev;
   FL_BLINE* next;
+  FL_BLINE* left;       // lines before this one in the tree
+  FL_BLINE* right;      // lines after this one in the tree
+  FL_BLINE* parent;
+  unsigned prio;        // heap priority of the tree node
+  int count;            // number of lines in this subtree
+  int height;           // item_height() of this line
+  int heights;          // sum of item_height() in this subtree
   void* data;
   Fl_Image* icon;
   short length;         // allocated size of txt[] (excl. null terminator); current string may be shorter
@@ -45,6 +53,67 @@ struct FL_BLINE {       // data is in a linked list of these
   char txt[1];          // start of allocated array
 };
 
+static inline int count(const FL_BLINE* t) {return t ? t->count : 0;}
+static inline int heights(const FL_BLINE* t) {return t ? t->heights : 0;}
+
+// Recalculate the sums of a tree node after its children changed:
+static void update(FL_BLINE* t) {
+  t->count = 1 + count(t->left) + count(t->right);
+  t->heights = t->height + heights(t->left) + heights(t->right);
+  if (t->left) t->left->parent = t;
+  if (t->right) t->right->parent = t;
+}
+
+// Join two trees, all lines of a come before all lines of b:
+static FL_BLINE* merge(FL_BLINE* a, FL_BLINE* b) {
+  if (!a) return b;
+  if (!b) return a;
+  if (a->prio >= b->prio) {
+    a->right = merge(a->right, b);
+    update(a);
+    return a;
+  }
+  b->left = merge(a, b->left);
+  update(b);
+  return b;
+}
+
+// Split a tree into its first n lines (l) and the rest (r):
+static void split(FL_BLINE* t, int n, FL_BLINE*& l, FL_BLINE*& r) {
+  if (!t) {l = r = 0; return;}
+  if (n <= count(t->left)) {
+    split(t->left, n, l, t->left);
+    update(t);
+    r = t;
+  } else {
+    split(t->right, n - count(t->left) - 1, t->right, r);
+    update(t);
+    l = t;
+  }
+}
+
+// Recalculate the sums of a whole tree after all heights changed:
+static void update_heights(FL_BLINE* t) {
+  if (!t) return;
+  update_heights(t->left);
+  update_heights(t->right);
+  t->heights = t->height + heights(t->left) + heights(t->right);
+}
+
+// Heap priority of a new tree node, a hash of its address:
+static unsigned random_prio(const FL_BLINE* t) {
+  unsigned long long h = (unsigned long long)(fl_uintptr_t)t;
+  h ^= h >> 33; h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return (unsigned)h;
+}
+
+// Update the sums of all parents of a line whose height changed:
+static void update_parents(FL_BLINE* t) {
+  for (; t; t = t->parent) t->heights = t->height + heights(t->left) + heights(t->right);
+}
+
 /** Get writable reference to FL_BLINE data. */
 void*& Fl_Browser::bline_data(FL_BLINE* b) const {
   return b->data;
@@ -167,13 +236,9 @@ const char *Fl_Browser::item_text(void *item) const {
 /**
   Returns the item for specified \p line.
 
-  Note: This call is slow. It's fine for e.g. responding to user
-  clicks, but slow if called often, such as in a tight sorting loop.
-  Finding an item 'by line' involves a linear lookup on the internal
-  linked list. The performance hit can be significant if the browser's
-  contents is large, and the method is called often (e.g. during a sort).
+  Finding an item 'by line' takes O(log n) time for n lines.
   If you're writing a subclass, use the protected methods item_first(),
-  item_next(), etc. to access the internal linked list more efficiently.
+  item_next(), etc. to walk the internal linked list more efficiently.
 
   \param[in] line The line number of the item to return. (1 based)
   \retval item that was found.
@@ -181,25 +246,23 @@ const char *Fl_Browser::item_text(void *item) const {
   \see item_at(), find_line(), lineno()
 */
 FL_BLINE* Fl_Browser::find_line(int line) const {
-  int n; FL_BLINE* l;
-  if (line == cacheline) return cache;
-  if (cacheline && line > (cacheline/2) && line < ((cacheline+lines)/2)) {
-    n = cacheline; l = cache;
-  } else if (line <= (lines/2)) {
-    n = 1; l = first;
-  } else {
-    n = lines; l = last;
+  FL_BLINE* t = root;
+  while (t) {
+    int n = count(t->left) + 1;
+    if (line == n) return t;
+    if (line < n) {
+      t = t->left;
+    } else {
+      line -= n;
+      t = t->right;
+    }
   }
-  for (; n < line && l; n++) l = l->next;
-  for (; n > line && l; n--) l = l->prev;
-  ((Fl_Browser*)this)->cacheline = line;
-  ((Fl_Browser*)this)->cache = l;
-  return l;
+  return 0;
 }
 
 /**
   Returns line number corresponding to \p item, or zero if not found.
-  Caveat: See efficiency note in find_line().
+  This takes O(log n) time for n lines.
   \param[in] item The item to be found
   \returns The line number of the item, or 0 if not found.
   \see item_at(), find_line(), lineno()
@@ -207,33 +270,14 @@ FL_BLINE* Fl_Browser::find_line(int line) const {
 int Fl_Browser::lineno(void *item) const {
   FL_BLINE* l = (FL_BLINE*)item;
   if (!l) return 0;
-  if (l == cache) return cacheline;
-  if (l == first) return 1;
-  if (l == last) return lines;
-  if (!cache) {
-    ((Fl_Browser*)this)->cache = first;
-    ((Fl_Browser*)this)->cacheline = 1;
-  }
-  // assume it is near cache, search both directions:
-  FL_BLINE* b = cache->prev;
-  int bnum = cacheline-1;
-  FL_BLINE* f = cache->next;
-  int fnum = cacheline+1;
-  int n = 0;
-  for (;;) {
-    if (b == l) {n = bnum; break;}
-    if (f == l) {n = fnum; break;}
-    if (b) {b = b->prev; bnum--;}
-    if (f) {f = f->next; fnum++;}
-  }
-  ((Fl_Browser*)this)->cache = l;
-  ((Fl_Browser*)this)->cacheline = n;
+  int n = count(l->left) + 1;
+  for (; l->parent; l = l->parent)
+    if (l == l->parent->right) n += count(l->parent->left) + 1;
   return n;
 }
 
 /**
   Removes the item at the specified \p line.
-  Caveat: See efficiency note in find_line().
   You must call redraw() to make any changes visible.
   \param[in] line The line number to be removed. (1 based) Must be in range!
   \returns Pointer to browser item that was removed (and is no longer valid).
@@ -243,15 +287,18 @@ FL_BLINE* Fl_Browser::_remove(int line) {
   FL_BLINE* ttt = find_line(line);
   deleting(ttt);
 
-  cacheline = line-1;
-  cache = ttt->prev;
   lines--;
-  full_height_ -= item_height(ttt) + linespacing();
   if (ttt->prev) ttt->prev->next = ttt->next;
   else first = ttt->next;
   if (ttt->next) ttt->next->prev = ttt->prev;
   else last = ttt->prev;
 
+  FL_BLINE *l, *m, *r;
+  split(root, line-1, l, m);
+  split(m, 1, m, r);
+  root = merge(l, r);
+  if (root) root->parent = 0;
+
   return(ttt);
 }
 
@@ -271,8 +318,6 @@ void Fl_Browser::remove(int line) {
   Insert specified \p item above \p line.
   If \p line > size() then the line is added to the end.
 
-  Caveat: See efficiency note in find_line().
-
   \param[in] line  The new line will be inserted above this line (1 based).
   \param[in] item  The item to be added.
 */
@@ -299,10 +344,15 @@ void Fl_Browser::insert(int line, FL_BLINE* item) {
     item->prev->next = item;
     n->prev = item;
   }
-  cacheline = line;
-  cache = item;
+  item->left = item->right = item->parent = 0;
+  item->prio = random_prio(item);
+  item->height = item_height(item);
+  update(item);
+  FL_BLINE *l, *r;
+  split(root, line < 1 ? 0 : line - 1, l, r);
+  root = merge(merge(l, item), r);
+  root->parent = 0;
   lines++;
-  full_height_ += item_height(item) + linespacing();
   redraw_line(item);
 }
 
@@ -361,7 +411,19 @@ void Fl_Browser::text(int line, const char* newtext) {
   if (l > t->length) {
     FL_BLINE* n = (FL_BLINE*)malloc(sizeof(FL_BLINE)+l);
     replacing(t, n);
-    cache = n;
+    // take t's place in the tree
+    n->left = t->left;
+    n->right = t->right;
+    n->parent = t->parent;
+    n->prio = t->prio;
+    n->count = t->count;
+    n->height = t->height;
+    n->heights = t->heights;
+    if (n->left) n->left->parent = n;
+    if (n->right) n->right->parent = n;
+    if (!n->parent) root = n;
+    else if (n->parent->left == t) n->parent->left = n;
+    else n->parent->right = n;
     n->data = t->data;
     n->icon = t->icon;
     n->length = (short)l;
@@ -374,6 +436,11 @@ void Fl_Browser::text(int line, const char* newtext) {
     t = n;
   }
   strcpy(t->txt, newtext);
+  int h = item_height(t);
+  if (h != t->height) {
+    t->height = h;
+    update_parents(t);
+  }
   redraw_line(t);
 }
 
@@ -516,7 +583,47 @@ int Fl_Browser::item_width(void *item) const {
        incr_height(), full_height()
 */
 int Fl_Browser::full_height() const {
-  return full_height_;
+  return heights(root) + lines * linespacing();
+}
+
+/*
+  Returns the line at pixel position pos and sets item_pos to its top edge.
+  This takes O(log n) time for n lines.
+*/
+void *Fl_Browser::item_at_position(int pos, int &item_pos) const {
+  FL_BLINE* t = root;
+  FL_BLINE* found = 0;
+  int ls = linespacing();
+  item_pos = 0;
+  int y = 0;
+  while (t) {
+    int top = y + heights(t->left) + count(t->left) * ls;
+    if (pos < top) {
+      t = t->left;
+    } else {
+      found = t;
+      item_pos = top;
+      y = top + t->height + ls;
+      if (pos < y) break;
+      t = t->right;
+    }
+  }
+  return found;
+}
+
+/*
+  Returns the pixel position of the top edge of item.
+  This takes O(log n) time for n lines.
+*/
+int Fl_Browser::item_position(void *item) const {
+  FL_BLINE* l = (FL_BLINE*)item;
+  if (!l) return -1;
+  int ls = linespacing();
+  int pos = heights(l->left) + count(l->left) * ls;
+  for (; l->parent; l = l->parent)
+    if (l == l->parent->right)
+      pos += heights(l->parent->left) + count(l->parent->left) * ls + l->parent->height + ls;
+  return pos;
 }
 
 /**
@@ -638,11 +745,9 @@ Fl_Browser::Fl_Browser(int X, int Y, int W, int H, const char *L)
 : Fl_Browser_(X, Y, W, H, L) {
   column_widths_ = no_columns;
   lines = 0;
-  full_height_ = 0;
-  cacheline = 0;
   format_char_ = '@';
   column_char_ = '\t';
-  first = last = cache = 0;
+  first = last = root = 0;
 }
 
 /**
@@ -656,11 +761,9 @@ void Fl_Browser::lineposition(int line, Fl_Line_Position pos) {
   if (line>lines) line = lines;
   int p = 0;
 
-  FL_BLINE* l;
-  for (l=first; l && line>1; l = l->next) {
-    line--; p += item_height(l) + linespacing();
-  }
-  if (l && (pos == BOTTOM)) p += item_height(l) + linespacing();
+  FL_BLINE* l = find_line(line);
+  if (l) p = item_position(l);
+  if (l && (pos == BOTTOM)) p += l->height + linespacing();
 
   int final = p, X, Y, W, H;
   bbox(X, Y, W, H);
@@ -687,9 +790,9 @@ int Fl_Browser::topline() const {
 /**
   Sets the default text size (in pixels) for the lines in the browser to \p newSize.
 
-  This method recalculates all item heights and caches the total height
-  internally for optimization of later item changes. This can be slow
-  if there are many items in the browser.
+  This method recalculates all item heights and caches them internally
+  for optimization of later item changes. This can be slow if there are
+  many items in the browser.
 
   It returns immediately (w/o recalculation) if \p newSize equals
   the current textsize().
@@ -705,11 +808,23 @@ void Fl_Browser::textsize(Fl_Fontsize newSize) {
     return; // avoid recalculation
   Fl_Browser_::textsize(newSize);
   new_list();
-  full_height_ = 0;
-  if (lines == 0) return;
+  heights_changed();
+}
+
+/**
+  Recalculates the cached heights of all lines.
+
+  Subclasses must call this when a setting other than textsize() changes
+  the item_height() of the lines, for instance the icon size of
+  Fl_File_Browser. This can be slow if there are many items in the browser.
+
+  \see textsize(Fl_Fontsize)
+*/
+void Fl_Browser::heights_changed() {
   for (FL_BLINE* itm=(FL_BLINE *)item_first(); itm; itm=(FL_BLINE *)item_next(itm)) {
-    full_height_ += item_height(itm) + linespacing();
+    itm->height = item_height(itm);
   }
+  update_heights(root);
 }
 
 /**
@@ -722,9 +837,9 @@ void Fl_Browser::clear() {
     free(l);
     l = n;
   }
-  full_height_ = 0;
   first = 0;
   last = 0;
+  root = 0;
   lines = 0;
   new_list();
 }
@@ -807,7 +922,8 @@ void Fl_Browser::show(int line) {
   FL_BLINE* t = find_line(line);
   if (t->flags & BLINE_NOTDISPLAYED) {
     t->flags &= ~BLINE_NOTDISPLAYED;
-    full_height_ += item_height(t) + linespacing();
+    t->height = item_height(t);
+    update_parents(t);
     if (Fl_Browser_::displayed(t)) redraw();
   }
 }
@@ -824,8 +940,9 @@ void Fl_Browser::show(int line) {
 void Fl_Browser::hide(int line) {
   FL_BLINE* t = find_line(line);
   if (!(t->flags & BLINE_NOTDISPLAYED)) {
-    full_height_ -= item_height(t) + linespacing();
     t->flags |= BLINE_NOTDISPLAYED;
+    t->height = 0;
+    update_parents(t);
     if (Fl_Browser_::displayed(t)) redraw();
   }
 }
@@ -901,9 +1018,16 @@ void Fl_Browser::swap(FL_BLINE *a, FL_BLINE *b) {
      if ( bprev ) bprev->next = a; else first = a;
      a->next = bnext;
   }
-  // Disable cache -- we played around with positions
-  cacheline = 0;
-  cache = 0;
+  // swap the positions in the tree
+  int ia = lineno(a), ib = lineno(b);
+  if (ia > ib) { int t = ia; ia = ib; ib = t; }
+  FL_BLINE *l, *ma, *m, *mb, *r;
+  split(root, ib - 1, l, r);
+  split(r, 1, mb, r);
+  split(l, ia - 1, l, m);
+  split(m, 1, ma, m);
+  root = merge(merge(merge(merge(l, mb), m), ma), r);
+  root->parent = 0;
 }
 
 /**
@@ -940,15 +1064,16 @@ void Fl_Browser::icon(int line, Fl_Image* icon) {
   if (th > old_h) old_h = th;
   if (th > new_h) new_h = th;
   int dh = new_h - old_h;
-  full_height_ += dh;                           // do this *always*
 
   bl->icon = icon;                              // set new icon
+  bl->height = item_height(bl);                 // do this *always*
+  update_parents(bl);
   if (dh>0) {
     redraw();                                   // icon larger than item? must redraw widget
   } else {
     redraw_line(bl);                            // icon same or smaller? can redraw just this line
   }
-  replacing(bl,bl);                             // recalc Fl_Browser_::max_width et al
+  replacing(bl,bl);                             // recalc Fl_Browser_::full_width() et al
 }
 
 /**
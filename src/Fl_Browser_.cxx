@@ -22,6 +22,7 @@
 #include <FL/Fl_Browser_.H>
 #include <FL/fl_draw.H>
 #include <FL/fl_utf8.h>
+#include "Fl_Browser_Widths.H"
 
 
 // This is the base class for browsers.  To be useful it must be
@@ -112,7 +113,7 @@ void Fl_Browser_::resize(int X, int Y, int W, int H) {
   hscrollbar.resize(
         X, scrollbar.align()&FL_ALIGN_TOP ? Y-scrollsize : Y+H,
         W, scrollsize);
-  max_width = 0;
+  widths_->clear();
 }
 
 // Cause minimal update to redraw the given item:
@@ -135,8 +136,11 @@ void Fl_Browser_::update_top() {
     void* l;
     int ly;
     int yy = position_;
-    // start from either head or current position, whichever is closer:
-    if (!top_ || yy <= (real_position_/2)) {
+    // find the item at this position if the subclass can do it quickly,
+    // else start from either head or current position, whichever is closer:
+    if ((l = item_at_position(yy, ly)) != 0) {
+      // use the item as a starting point, the walk below checks it
+    } else if (!top_ || yy <= (real_position_/2)) {
       l = item_first();
       ly = 0;
     } else {
@@ -259,6 +263,25 @@ void Fl_Browser_::display(void* item) {
   void* lp = item_prev(l);
   if (lp == item) { vposition(real_position_+Y-item_quick_height(lp)-linespacing()); return; }
 
+  // 4th special case - subclass knows the position of the item?
+  int pos = item_position(item);
+  if (pos >= 0) {
+    h1 = item_quick_height(item) + linespacing();
+    Y = pos - real_position_;
+    if (Y >= 0) { // it is below the top
+      if (Y <= H) { // it is visible or right at bottom
+        Y = Y+h1-H; // find where bottom edge is
+        if (Y > 0) vposition(real_position_+Y); // scroll down a bit
+      } else {
+        vposition(real_position_+Y-(H-h1)/2); // center it
+      }
+    } else { // it is above the top
+      if ((Y + h1) >= 0) vposition(real_position_+Y);
+      else vposition(real_position_+Y-(H-h1)/2);
+    }
+    return;
+  }
+
 #ifdef DISPLAY_SEARCH_BOTH_WAYS_AT_ONCE
   // search for item.  We search both up and down the list at the same time,
   // this evens up the execution time for the two cases - the old way was
@@ -411,8 +434,7 @@ J1:
         draw_box(FL_BORDER_FRAME, X, yy+Y, W, hh, color());
         draw_focus(FL_NO_BOX, X, yy+Y, W+1, hh+1);
       }
-      int ww = item_width(l);
-      if (ww > max_width) {max_width = ww; max_width_item = l;}
+      widths_->set(l, item_width(l));
     }
     yy += hh;
   }
@@ -492,8 +514,7 @@ void Fl_Browser_::new_list() {
   hposition_ = real_hposition_ = 0;
   selection_ = 0;
   offset_ = 0;
-  max_width = 0;
-  max_width_item = 0;
+  widths_->clear();
   redraw_lines();
 }
 
@@ -522,7 +543,7 @@ void Fl_Browser_::deleting(void* item) {
     top_ = 0;
   }
   if (item == selection_) selection_ = 0;
-  if (item == max_width_item) {max_width_item = 0; max_width = 0;}
+  widths_->remove(item);
 }
 
 /**
@@ -538,7 +559,7 @@ void Fl_Browser_::replacing(void* a, void* b) {
   redraw_line(a);
   if (a == selection_) selection_ = b;
   if (a == top_) top_ = b;
-  if (a == max_width_item) {max_width_item = 0; max_width = 0;}
+  widths_->remove(a);
 }
 
 /**
@@ -999,13 +1020,20 @@ Fl_Browser_::Fl_Browser_(int X, int Y, int W, int H, const char* L)
   textsize_ = FL_NORMAL_SIZE;
   textcolor_ = FL_FOREGROUND_COLOR;
   has_scrollbar_ = BOTH;
-  max_width = 0;
-  max_width_item = 0;
+  widths_ = new Fl_Browser_Widths;
   scrollbar_size_ = 0;
   redraw1 = redraw2 = 0;
   end();
 }
 
+/**
+  Destroys the browser.
+  The subclass is responsible for deleting its items.
+*/
+Fl_Browser_::~Fl_Browser_() {
+  delete widths_;
+}
+
 /**
   Sort the items in the browser based on \p flags.
   item_swap(void*, void*) and item_text(void*) must be implemented for this call.
@@ -1099,11 +1127,13 @@ int Fl_Browser_::full_height() const {
 /**
   This method may be provided by the subclass to indicate the full width
   of the item list, in pixels.
-  The default implementation computes the full width from the item widths.
+  The default implementation returns the largest item_width() of all items
+  that were drawn since the last new_list(). It is updated in O(log n) time
+  when an item is deleted or replaced, without measuring the other items.
   \returns The maximum width of all the items, in pixels.
 */
 int Fl_Browser_::full_width() const {
-  return max_width;
+  return widths_->max();
 }
 
 /**
@@ -0,0 +1,43 @@
+//
+// Item width histogram for Fl_Browser_ for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Browser_Widths.H"
+
+
+void Fl_Browser_Widths::uncount_(int w) {
+  std::map<int, int>::iterator it = counts_.find(w);
+  if (it != counts_.end() && --it->second == 0) counts_.erase(it);
+}
+
+
+void Fl_Browser_Widths::set(const void *item, int w) {
+  std::pair<std::unordered_map<const void*, int>::iterator, bool> r =
+    items_.insert(std::make_pair(item, w));
+  if (!r.second) {
+    if (r.first->second == w) return;
+    uncount_(r.first->second);
+    r.first->second = w;
+  }
+  counts_[w]++;
+}
+
+
+void Fl_Browser_Widths::remove(const void *item) {
+  std::unordered_map<const void*, int>::iterator it = items_.find(item);
+  if (it == items_.end()) return;
+  uncount_(it->second);
+  items_.erase(it);
+}
@@ -21,6 +21,7 @@
 //   Fl_File_Browser::item_width()      - Return the width of a list item.
 //   Fl_File_Browser::item_draw()       - Draw a list item.
 //   Fl_File_Browser::Fl_File_Browser() - Create a Fl_File_Browser widget.
+//   Fl_File_Browser::textsize()        - Set the text and icon size.
 //   Fl_File_Browser::load()            - Load a directory into the browser.
 //   Fl_File_Browser::filter()          - Set the filename filter.
 //
@@ -47,12 +48,12 @@
 int                                     // O - Height in pixels
 Fl_File_Browser::full_height() const
 {
-  int   i,                              // Looping var
-        th;                             // Total height of list.
+  void  *p;                             // Looping var
+  int   th;                             // Total height of list.
 
 
-  for (i = 0, th = 0; i < size(); i ++)
-    th += item_height(find_line(i)) + linespacing();
+  for (p = item_first(), th = 0; p; p = item_next(p))
+    th += item_height(p) + linespacing();
 
   return (th);
 }
@@ -360,6 +361,26 @@ Fl_File_Browser::~Fl_File_Browser() {
 }
 
 
+//
+// 'Fl_File_Browser::textsize()' - Set the text and icon size.
+//
+
+/**
+  Sets the text size of the lines and the icon size to 1.5 times of it.
+  \param[in] s the new text size
+*/
+void
+Fl_File_Browser::textsize(Fl_Fontsize s)        // I - Text size
+{
+  // Set the icon size first, the line heights depend on both
+  iconsize_ = (uchar)(3 * s / 2);
+  if (s != textsize())
+    Fl_Browser::textsize(s);
+  else
+    heights_changed();
+}
+
+
 /**
   Sets OS error message to a string, which can be NULL.
   Frees previous if any.
@@ -20,6 +20,7 @@
 #include <FL/Fl_Widget.H>
 #include <FL/Fl_Menu_Item.H>
 #include <FL/Fl_Image.H>
+#include "Fl_Image_Resampler.H"
 #include "flstring.h"
 
 #include <stdlib.h>
@@ -250,6 +251,11 @@ Fl_Image::measure(const Fl_Label *lo,           // I - Label
 
 /** Sets the RGB image scaling method used for copy(int, int).
     Applies to all RGB images, defaults to FL_RGB_SCALING_NEAREST.
+
+    FL_RGB_SCALING_AREA computes every pixel of the copy as the average of
+    all source pixels it covers, and is the best choice for thumbnails and
+    other large reductions. Large images are scaled by several threads
+    if the platform supports them.
 */
 void Fl_Image::RGB_scaling(Fl_RGB_Scaling method) {
   RGB_scaling_ = method;
@@ -550,6 +556,18 @@ Fl_RGB_Image *Fl_RGB_Image::copy_nearest_neighbor_(int W, int H) const {
 }
 
 
+/**
+ Create a scaled up or down copy of this image by area averaging.
+ */
+Fl_RGB_Image *Fl_RGB_Image::copy_area_(int W, int H) const {
+  uchar *new_array = new uchar [((long)W) * H * d()];
+  Fl_Image_Resampler(array, data_w(), data_h(), d(), ld(), new_array, W, H).resample();
+  Fl_RGB_Image *new_image = new Fl_RGB_Image(new_array, W, H, d());
+  new_image->alloc_array = 1;
+  return new_image;
+}
+
+
 Fl_RGB_Image *Fl_RGB_Image::copy_bilinear_(int W, int H) const {
   Fl_RGB_Image  *new_image;     // New RGB image
   uchar         *new_array;     // New array for image data
@@ -732,6 +750,8 @@ Fl_Image *Fl_RGB_Image::copy(int W, int H) const {
   if (W <= 0 || H <= 0) return nullptr;
   if (Fl_Image::RGB_scaling() == FL_RGB_SCALING_NEAREST) {
     return copy_nearest_neighbor_(W, H);
+  } else if (Fl_Image::RGB_scaling() == FL_RGB_SCALING_AREA) {
+    return copy_area_(W, H);
   } else {
     // Bilinear scaling only scales down between 100% and 50%. If our image is
     // much larger, divide it by two in either direction first. This is not
@@ -0,0 +1,182 @@
+//
+// Area-averaging image resampler for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <config.h>
+#include "Fl_Image_Resampler.H"
+
+#include <algorithm>
+#if defined(HAVE_PTHREAD)
+#  include <thread>
+#endif
+
+// Resampling less source pixels than this is not worth starting threads
+static const long MIN_THREAD_WORK = 1L << 20;
+static const int MAX_THREADS = 8;
+
+
+void Fl_Image_Resampler::Axis::init(int src, int dst) {
+  first.resize(dst);
+  count.resize(dst);
+  offset.resize(dst);
+  weight.clear();
+  for (int i = 0; i < dst; i++) {
+    offset[i] = (int)weight.size();
+    if (dst < src) {
+      // Scale down: pixel i covers the source range a..b in units of 1/dst
+      // source pixels, and every source pixel is weighted by its overlap.
+      long long a = (long long)i * src, b = a + src;
+      int j0 = int(a / dst), j1 = int((b - 1) / dst);
+      int sum = 0, widest = offset[i], max = 0;
+      for (int j = j0; j <= j1; j++) {
+        long long lo = std::max(a, (long long)j * dst);
+        long long hi = std::min(b, (long long)(j + 1) * dst);
+        int w = int((hi - lo) * ONE / src);
+        if (w > max) { max = w; widest = (int)weight.size(); }
+        weight.push_back(w);
+        sum += w;
+      }
+      weight[widest] += ONE - sum;                // rounding errors
+      first[i] = j0;
+      count[i] = j1 - j0 + 1;
+    } else {
+      // Scale up: interpolate between the two nearest source pixels
+      long long pos = ((2LL * i + 1) * src - dst) * ONE / (2LL * dst);
+      int j = int(pos / ONE), f = int(pos % ONE);
+      if (pos < 0) j = f = 0;
+      if (j >= src - 1) { j = src - 1; f = 0; }
+      first[i] = j;
+      if (f) {
+        count[i] = 2;
+        weight.push_back(ONE - f);
+        weight.push_back(f);
+      } else {
+        count[i] = 1;
+        weight.push_back(ONE);
+      }
+    }
+  }
+}
+
+
+Fl_Image_Resampler::Fl_Image_Resampler(const uchar *src, int w, int h, int d, int ld,
+                                       uchar *dst, int W, int H)
+: src_(src), w_(w), h_(h), d_(d), ld_(ld ? ld : w * d), dst_(dst), W_(W), H_(H) {
+  x_.init(w, W);
+  y_.init(h, H);
+}
+
+
+// Resample source rows from..to-1 of an image with D channels horizontally
+// into rows. Colors are multiplied by alpha (or by 255 without alpha), so
+// rows has 16 bits per channel.
+template <int D>
+static void horizontal_pass(const uchar *src, int ld, int from, int to,
+                            const std::vector<int> &first, const std::vector<int> &count,
+                            const std::vector<int> &offset, const std::vector<int> &weight,
+                            unsigned short *rows) {
+  const int W = (int)first.size();
+  const bool alpha = !(D & 1);
+  for (int y = from; y < to; y++) {
+    const uchar *s = src + (long)y * ld;
+    unsigned short *r = rows + (size_t)y * W * D;
+    for (int i = 0; i < W; i++) {
+      int acc[D];
+      for (int c = 0; c < D; c++) acc[c] = Fl_Image_Resampler::ONE / 2;
+      const int *wt = &weight[offset[i]];
+      const uchar *p = s + first[i] * D;
+      for (int k = count[i]; k > 0; k--, p += D, wt++) {
+        const int a = alpha ? p[D - 1] : 255;
+        for (int c = 0; c < D - alpha; c++) acc[c] += *wt * (p[c] * a);
+        if (alpha) acc[D - 1] += *wt * (a * 255);
+      }
+      for (int c = 0; c < D; c++) *r++ = (unsigned short)(acc[c] >> 14);
+    }
+  }
+}
+
+
+void Fl_Image_Resampler::horizontal(int from, int to) {
+  void (*pass)(const uchar *, int, int, int, const std::vector<int> &, const std::vector<int> &,
+               const std::vector<int> &, const std::vector<int> &, unsigned short *);
+  switch (d_) {
+    case 1:  pass = horizontal_pass<1>; break;
+    case 2:  pass = horizontal_pass<2>; break;
+    case 3:  pass = horizontal_pass<3>; break;
+    default: pass = horizontal_pass<4>; break;
+  }
+  pass(src_, ld_, from, to, x_.first, x_.count, x_.offset, x_.weight, &rows_[0]);
+}
+
+
+// Compute destination rows from..to-1 from rows_
+void Fl_Image_Resampler::vertical(int from, int to) {
+  const int d = d_, n = W_ * d;
+  std::vector<int> acc(n);
+  for (int y = from; y < to; y++) {
+    std::fill(acc.begin(), acc.end(), (int)ONE/2);
+    for (int k = 0; k < y_.count[y]; k++) {
+      const int wt = y_.weight[y_.offset[y] + k];
+      const unsigned short *r = &rows_[(size_t)(y_.first[y] + k) * n];
+      for (int i = 0; i < n; i++) acc[i] += wt * r[i];
+    }
+    uchar *out = dst_ + (long)y * n;
+    if (d & 1) {
+      for (int i = 0; i < n; i++) out[i] = uchar(((acc[i] >> 14) + 127) / 255);
+    } else {
+      // divide the colors by alpha
+      for (int i = 0; i < n; i += d) {
+        int a = acc[i + d - 1] >> 14;
+        for (int c = 0; c < d - 1; c++)
+          out[i + c] = a ? uchar(std::min(255, ((acc[i + c] >> 14) * 255 + a / 2) / a)) : 0;
+        out[i + d - 1] = uchar((a + 127) / 255);
+      }
+    }
+  }
+}
+
+
+// Run pass on rows 0..rows-1, in several threads if there is enough work
+void Fl_Image_Resampler::run(void (Fl_Image_Resampler::*pass)(int, int), int rows, long work) {
+  int n = 1;
+#if defined(HAVE_PTHREAD)
+  if (work >= MIN_THREAD_WORK)
+    n = std::min(std::min((int)std::thread::hardware_concurrency(), MAX_THREADS), rows);
+  if (n > 1) {
+    std::vector<std::thread> threads;
+    for (int t = 1; t < n; t++) {
+      try {
+        threads.push_back(std::thread(pass, this, rows * t / n, rows * (t + 1) / n));
+      } catch (...) {                          // no more threads: do it here
+        (this->*pass)(rows * t / n, rows * (t + 1) / n);
+      }
+    }
+    (this->*pass)(0, rows / n);
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    return;
+  }
+#endif
+  (void)work;
+  (this->*pass)(0, rows);
+}
+
+
+void Fl_Image_Resampler::resample() {
+  rows_.resize((size_t)h_ * W_ * d_);
+  run(&Fl_Image_Resampler::horizontal, h_, (long)w_ * h_);
+  run(&Fl_Image_Resampler::vertical, H_, (long)W_ * h_);
+  rows_.clear();
+  rows_.shrink_to_fit();
+}
@@ -32,7 +32,9 @@
 #include <config.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <setjmp.h>
+#include <vector>
 
 
 // Some releases of the Cygwin JPEG libraries don't have a correctly
@@ -135,6 +137,52 @@ Fl_JPEG_Image::Fl_JPEG_Image(const char *name, const unsigned char *data, int da
   load_jpg_(0L, name, data, data_length);
 }
 
+/**
+ \brief The constructor loads a reduced size JPEG image from the given file.
+
+ The image is decoded at 1/2, 1/4, or 1/8 of its size if that is still at
+ least \p W x \p H pixels, which is several times faster than decoding the
+ full image and uses much less memory. This is meant for thumbnails and
+ previews: the size of the image is not exactly \p W x \p H, use scale()
+ or copy(int, int) to get that size.
+
+ Reduced images are decoded with the fast integer DCT of the JPEG library,
+ so their quality is slightly lower. If \p W or \p H is 0 or the image is
+ not larger than twice the requested size, the full image is loaded.
+
+ \param[in] filename a full path and name pointing to a valid jpeg file.
+ \param[in] W, H the minimum size of the image
+
+ \see Fl_JPEG_Image::Fl_JPEG_Image(const char *filename)
+ \version 1.5.0
+ */
+Fl_JPEG_Image::Fl_JPEG_Image(const char *filename, int W, int H)
+: Fl_RGB_Image(0,0,0)
+{
+  load_jpg_(filename, 0L, 0L, -1, W, H);
+}
+
+/**
+ \brief The constructor loads a reduced size JPEG image from memory.
+
+ See Fl_JPEG_Image::Fl_JPEG_Image(const char *filename, int W, int H)
+ for how the size of the image is chosen, and
+ Fl_JPEG_Image::Fl_JPEG_Image(const char *name, const unsigned char *data, int data_length)
+ for the other parameters.
+
+ \param name A unique name or NULL
+ \param data A pointer to the memory location of the JPEG image
+ \param data_length length of \c data, or -1 if unknown
+ \param W, H the minimum size of the image
+
+ \version 1.5.0
+ */
+Fl_JPEG_Image::Fl_JPEG_Image(const char *name, const unsigned char *data, int data_length, int W, int H)
+: Fl_RGB_Image(0,0,0)
+{
+  load_jpg_(0L, name, data, data_length, W, H);
+}
+
 
 // data source manager for reading jpegs from memory
 // init_source (j_decompress_ptr cinfo)
@@ -233,9 +281,11 @@ struct load_stat {
  This method reads JPEG image data and creates an RGB or grayscale image.
  To avoid code duplication, we set filename if we want to read from a file
  or data to read from memory instead. Sharename can be set if the image is
- supposed to be added to the Fl_Shared_Image list.
+ supposed to be added to the Fl_Shared_Image list. If W and H are set,
+ the image is decoded at the smallest scale that is at least W x H.
  */
-void Fl_JPEG_Image::load_jpg_(const char *filename, const char *sharename, const unsigned char *data, int data_length)
+void Fl_JPEG_Image::load_jpg_(const char *filename, const char *sharename, const unsigned char *data, int data_length,
+                              int W, int H)
 {
 #ifdef HAVE_LIBJPEG
   jpeg_decompress_struct  dinfo;    // Decompressor info
@@ -314,6 +364,21 @@ void Fl_JPEG_Image::load_jpg_(const char *filename, const char *sharename, const
   dinfo.out_color_components = 3;
   dinfo.output_components    = 3;
 
+  // Let the decoder scale the image down in the DCT domain
+  if (W > 0 && H > 0) {
+    unsigned denom = 1;
+    while (denom < 8 &&
+           (dinfo.image_width + 2 * denom - 1) / (2 * denom) >= (unsigned)W &&
+           (dinfo.image_height + 2 * denom - 1) / (2 * denom) >= (unsigned)H)
+      denom *= 2;
+    if (denom > 1) {
+      dinfo.scale_num           = 1;
+      dinfo.scale_denom         = denom;
+      dinfo.dct_method          = JDCT_IFAST;
+      dinfo.do_fancy_upsampling = (boolean)FALSE;
+    }
+  }
+
   jpeg_calc_output_dimensions(&dinfo);
 
   w(dinfo.output_width);
@@ -344,3 +409,173 @@ void Fl_JPEG_Image::load_jpg_(const char *filename, const char *sharename, const
   }
 #endif // HAVE_LIBJPEG
 }
+
+
+//
+// Progressive JPEG decoding with a suspending data source
+//
+
+#ifdef HAVE_LIBJPEG
+
+// The data source keeps the data that the decompressor did not use yet.
+// When it runs out of data, the decompressor is suspended until write()
+// adds more data and calls decode() again.
+struct Fl_JPEG_Decoder {
+  enum { HEADER, START, ROWS, FINISH, DONE };
+  Fl_Progressive_JPEG_Image *img;
+  jpeg_decompress_struct dinfo;
+  fl_jpeg_error_mgr jerr;
+  jpeg_source_mgr src;
+  std::vector<JOCTET> buffer;   // data not used yet, starting before src.next_input_byte
+  size_t skip;                  // bytes to skip that have not arrived yet
+  int state;
+
+  Fl_JPEG_Decoder(Fl_Progressive_JPEG_Image *image);
+  ~Fl_JPEG_Decoder() { jpeg_destroy_decompress(&dinfo); }
+  void add(const unsigned char *data, size_t n);
+  void decode();
+};
+
+extern "C" {
+  static void fl_jpeg_progressive_init_source(j_decompress_ptr) {
+  }
+
+  static boolean fl_jpeg_progressive_fill_input_buffer(j_decompress_ptr) {
+    return FALSE;       // suspend until more data arrives
+  }
+
+  static void fl_jpeg_progressive_skip_input_data(j_decompress_ptr cinfo, long num_bytes) {
+    if (num_bytes <= 0) return;
+    jpeg_source_mgr *src = cinfo->src;
+    if ((size_t)num_bytes > src->bytes_in_buffer) {
+      ((Fl_JPEG_Decoder *)cinfo->client_data)->skip += (size_t)num_bytes - src->bytes_in_buffer;
+      num_bytes = (long)src->bytes_in_buffer;
+    }
+    src->next_input_byte += num_bytes;
+    src->bytes_in_buffer -= (size_t)num_bytes;
+  }
+
+  static void fl_jpeg_progressive_term_source(j_decompress_ptr) {
+  }
+}
+
+Fl_JPEG_Decoder::Fl_JPEG_Decoder(Fl_Progressive_JPEG_Image *image)
+: img(image), skip(0), state(HEADER)
+{
+  memset(&dinfo, 0, sizeof(dinfo));
+  dinfo.err                = jpeg_std_error((jpeg_error_mgr *)&jerr);
+  jerr.pub_.error_exit     = fl_jpeg_error_handler;
+  jerr.pub_.output_message = fl_jpeg_output_handler;
+  dinfo.client_data        = this;
+  src.init_source          = fl_jpeg_progressive_init_source;
+  src.fill_input_buffer    = fl_jpeg_progressive_fill_input_buffer;
+  src.skip_input_data      = fl_jpeg_progressive_skip_input_data;
+  src.resync_to_restart    = jpeg_resync_to_restart;
+  src.term_source          = fl_jpeg_progressive_term_source;
+  src.next_input_byte      = NULL;
+  src.bytes_in_buffer      = 0;
+}
+
+// Append data to the unused data of the decompressor
+void Fl_JPEG_Decoder::add(const unsigned char *data, size_t n) {
+  buffer.erase(buffer.begin(), buffer.begin() + (buffer.size() - src.bytes_in_buffer));
+  size_t s = (skip < n) ? skip : n;
+  skip -= s;
+  buffer.insert(buffer.end(), data + s, data + n);
+  src.next_input_byte = buffer.empty() ? NULL : &buffer[0];
+  src.bytes_in_buffer = buffer.size();
+}
+
+// Decode as much of the image as the data allows
+void Fl_JPEG_Decoder::decode() {
+  if (state == HEADER) {
+    if (jpeg_read_header(&dinfo, TRUE) == JPEG_SUSPENDED) return;
+    dinfo.quantize_colors      = (boolean)FALSE;
+    dinfo.out_color_space      = JCS_RGB;
+    dinfo.out_color_components = 3;
+    dinfo.output_components    = 3;
+    jpeg_calc_output_dimensions(&dinfo);
+    if (img->alloc_pixels_(dinfo.output_width, dinfo.output_height, dinfo.output_components) < 0)
+      longjmp(jerr.errhand_, 1);
+    state = START;
+  }
+  if (state == START) {
+    if (!jpeg_start_decompress(&dinfo)) return;
+    state = ROWS;
+  }
+  if (state == ROWS) {
+    int y = dinfo.output_scanline;
+    while (dinfo.output_scanline < dinfo.output_height) {
+      JSAMPROW row = (JSAMPROW)(img->array +
+                                ((size_t)dinfo.output_scanline) * dinfo.output_width *
+                                dinfo.output_components);
+      if (jpeg_read_scanlines(&dinfo, &row, (JDIMENSION)1) == 0) break;
+    }
+    img->rows_changed_(y, dinfo.output_scanline - y);
+    if (dinfo.output_scanline < dinfo.output_height) return;
+    state = FINISH;
+  }
+  if (state == FINISH) {
+    if (!jpeg_finish_decompress(&dinfo)) return;
+    img->complete_image_();
+    state = DONE;
+  }
+}
+
+#else
+
+struct Fl_JPEG_Decoder { };
+
+#endif // HAVE_LIBJPEG
+
+
+/**
+ Creates an empty image that decodes the JPEG data passed to write().
+ */
+Fl_Progressive_JPEG_Image::Fl_Progressive_JPEG_Image()
+: Fl_Progressive_Image(),
+  decoder_(0)
+{
+#ifdef HAVE_LIBJPEG
+  decoder_ = new Fl_JPEG_Decoder(this);
+  if (setjmp(decoder_->jerr.errhand_)) {
+    Fl::warning("Cannot allocate memory to read JPEG data.\n");
+    delete decoder_;
+    decoder_ = 0;
+    fail_();
+    return;
+  }
+  jpeg_create_decompress(&decoder_->dinfo);
+  decoder_->dinfo.src = &decoder_->src;
+#else
+  fail_();
+#endif // HAVE_LIBJPEG
+}
+
+Fl_Progressive_JPEG_Image::~Fl_Progressive_JPEG_Image() {
+  delete decoder_;
+}
+
+int Fl_Progressive_JPEG_Image::write(const unsigned char *data, size_t n) {
+  if (complete()) return 0;
+  if (!decoder_) return -1;
+#ifdef HAVE_LIBJPEG
+  decoder_->add(data, n);
+  if (setjmp(decoder_->jerr.errhand_)) {
+    Fl::warning("JPEG data is too large or contains errors!\n");
+    delete decoder_;
+    decoder_ = 0;
+    fail_();
+    return -1;
+  }
+  decoder_->decode();
+  if (complete()) {
+    delete decoder_;
+    decoder_ = 0;
+  }
+  flush_rows_();
+  return 0;
+#else
+  return -1;
+#endif // HAVE_LIBJPEG
+}
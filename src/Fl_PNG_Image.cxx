@@ -35,6 +35,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
 extern "C"
@@ -69,6 +70,41 @@ extern "C" {
     png_mem_data->current += length;
   }
 } // extern "C"
+
+// Set up the conversion to 8-bit grayscale or RGB with optional alpha
+// channel, returns the number of channels of the converted image
+static int fl_png_set_transforms(png_structp pp, png_infop info) {
+  int channels;
+
+  if (png_get_color_type(pp, info) == PNG_COLOR_TYPE_PALETTE)
+    png_set_expand(pp);
+
+  if (png_get_color_type(pp, info) & PNG_COLOR_MASK_COLOR)
+    channels = 3;
+  else
+    channels = 1;
+
+  int num_trans = 0;
+  png_get_tRNS(pp, info, 0, &num_trans, 0);
+  if ((png_get_color_type(pp, info) & PNG_COLOR_MASK_ALPHA) || (num_trans != 0))
+    channels ++;
+
+  if (png_get_bit_depth(pp, info) < 8)
+  {
+    png_set_packing(pp);
+    png_set_expand(pp);
+  }
+  else if (png_get_bit_depth(pp, info) == 16)
+    png_set_strip_16(pp);
+
+#  if defined(HAVE_PNG_GET_VALID) && defined(HAVE_PNG_SET_TRNS_TO_ALPHA)
+  // Handle transparency...
+  if (png_get_valid(pp, info, PNG_INFO_tRNS))
+    png_set_tRNS_to_alpha(pp);
+#  endif // HAVE_PNG_GET_VALID && HAVE_PNG_SET_TRNS_TO_ALPHA
+
+  return channels;
+}
 #endif // HAVE_LIBPNG && HAVE_LIBZ
 
 
@@ -183,37 +219,12 @@ void Fl_PNG_Image::load_png_(const char *name_png, int offset, const unsigned ch
   // Get the image dimensions and convert to grayscale or RGB...
   png_read_info(pp, info);
 
-  if (png_get_color_type(pp, info) == PNG_COLOR_TYPE_PALETTE)
-    png_set_expand(pp);
-
-  if (png_get_color_type(pp, info) & PNG_COLOR_MASK_COLOR)
-    channels = 3;
-  else
-    channels = 1;
-
-  int num_trans = 0;
-  png_get_tRNS(pp, info, 0, &num_trans, 0);
-  if ((png_get_color_type(pp, info) & PNG_COLOR_MASK_ALPHA) || (num_trans != 0))
-    channels ++;
+  channels = fl_png_set_transforms(pp, info);
 
   w((int)(png_get_image_width(pp, info)));
   h((int)(png_get_image_height(pp, info)));
   d(channels);
 
-  if (png_get_bit_depth(pp, info) < 8)
-  {
-    png_set_packing(pp);
-    png_set_expand(pp);
-  }
-  else if (png_get_bit_depth(pp, info) == 16)
-    png_set_strip_16(pp);
-
-#  if defined(HAVE_PNG_GET_VALID) && defined(HAVE_PNG_SET_TRNS_TO_ALPHA)
-  // Handle transparency...
-  if (png_get_valid(pp, info, PNG_INFO_tRNS))
-    png_set_tRNS_to_alpha(pp);
-#  endif // HAVE_PNG_GET_VALID && HAVE_PNG_SET_TRNS_TO_ALPHA
-
   if (((size_t)w()) * h() * d() > max_size() ) longjmp(png_jmpbuf(pp), 1);
   array = new uchar[w() * h() * d()];
   alloc_array = 1;
@@ -247,3 +258,139 @@ void Fl_PNG_Image::load_png_(const char *name_png, int offset, const unsigned ch
   delete fp;
 #endif // HAVE_LIBPNG && HAVE_LIBZ
 }
+
+
+//
+// Progressive PNG decoding with the libpng progressive reader
+//
+
+#if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
+
+// Size of the block of pixels that a pixel of each Adam7 pass is copied to.
+// The blocks contain no pixels of earlier passes, and the pixels of later
+// passes replace the copies when they are decoded.
+static const int adam7_block_w[7] = { 8, 4, 4, 2, 2, 1, 1 };
+static const int adam7_block_h[7] = { 8, 8, 4, 4, 2, 2, 1 };
+
+struct Fl_PNG_Decoder {
+  Fl_Progressive_PNG_Image *img;
+  png_structp pp;
+  png_infop info;
+  int interlaced;
+
+  Fl_PNG_Decoder(Fl_Progressive_PNG_Image *image)
+  : img(image), pp(0), info(0), interlaced(0) { }
+  ~Fl_PNG_Decoder() {
+    if (pp) png_destroy_read_struct(&pp, info ? &info : NULL, NULL);
+  }
+  void header();
+  void row(const uchar *data, int y, int pass);
+  void end() { img->complete_image_(); }
+};
+
+extern "C" {
+  static void fl_png_progressive_info(png_structp pp, png_infop) {
+    ((Fl_PNG_Decoder *)png_get_progressive_ptr(pp))->header();
+  }
+  static void fl_png_progressive_row(png_structp pp, png_bytep row, png_uint_32 y, int pass) {
+    if (row) ((Fl_PNG_Decoder *)png_get_progressive_ptr(pp))->row(row, (int)y, pass);
+  }
+  static void fl_png_progressive_end(png_structp pp, png_infop) {
+    ((Fl_PNG_Decoder *)png_get_progressive_ptr(pp))->end();
+  }
+} // extern "C"
+
+void Fl_PNG_Decoder::header() {
+  int channels = fl_png_set_transforms(pp, info);
+  // Don't call png_set_interlace_handling(), we get the pixels of
+  // each pass and spread them over the image ourselves
+  interlaced = (png_get_interlace_type(pp, info) != PNG_INTERLACE_NONE);
+  png_read_update_info(pp, info);
+  if (img->alloc_pixels_((int)png_get_image_width(pp, info),
+                         (int)png_get_image_height(pp, info), channels) < 0)
+    png_error(pp, "image too large");
+}
+
+// Store row y of an interlace pass, or row y of the image if it isn't interlaced
+void Fl_PNG_Decoder::row(const uchar *data, int y, int pass) {
+  const int W = img->w(), H = img->h(), D = img->d();
+  uchar *array = (uchar *)img->array;
+  int bh = 1;
+  if (!interlaced) {
+    memcpy(array + ((size_t)y) * W * D, data, ((size_t)W) * D);
+  } else {
+    y = (int)PNG_ROW_FROM_PASS_ROW(y, pass);
+    bh = adam7_block_h[pass];
+    if (bh > H - y) bh = H - y;
+    const int bw = adam7_block_w[pass], dx = 1 << PNG_PASS_COL_SHIFT(pass);
+    for (int x = PNG_PASS_START_COL(pass); x < W; x += dx, data += D) {
+      int n = (bw < W - x) ? bw : W - x;
+      for (int r = 0; r < bh; r++) {
+        uchar *p = array + (((size_t)(y + r)) * W + x) * D;
+        for (int i = 0; i < n; i++, p += D) memcpy(p, data, D);
+      }
+    }
+  }
+  if (D == 4)
+    Fl::system_driver()->png_extra_rgba_processing(array + ((size_t)y) * W * D, W, bh);
+  img->rows_changed_(y, bh);
+}
+
+#else
+
+struct Fl_PNG_Decoder { };
+
+#endif // HAVE_LIBPNG && HAVE_LIBZ
+
+
+/**
+ Creates an empty image that decodes the PNG data passed to write().
+ */
+Fl_Progressive_PNG_Image::Fl_Progressive_PNG_Image()
+: Fl_Progressive_Image(),
+  decoder_(0)
+{
+#if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
+  decoder_ = new Fl_PNG_Decoder(this);
+  decoder_->pp = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (decoder_->pp) decoder_->info = png_create_info_struct(decoder_->pp);
+  if (!decoder_->info) {
+    Fl::warning("Cannot allocate memory to read PNG data.\n");
+    delete decoder_;
+    decoder_ = 0;
+    fail_();
+    return;
+  }
+  png_set_progressive_read_fn(decoder_->pp, decoder_, fl_png_progressive_info,
+                              fl_png_progressive_row, fl_png_progressive_end);
+#else
+  fail_();
+#endif // HAVE_LIBPNG && HAVE_LIBZ
+}
+
+Fl_Progressive_PNG_Image::~Fl_Progressive_PNG_Image() {
+  delete decoder_;
+}
+
+int Fl_Progressive_PNG_Image::write(const unsigned char *data, size_t n) {
+  if (complete()) return 0;
+  if (!decoder_) return -1;
+#if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
+  if (setjmp(png_jmpbuf(decoder_->pp))) {
+    Fl::warning("PNG data is too large or contains errors!\n");
+    delete decoder_;
+    decoder_ = 0;
+    fail_();
+    return -1;
+  }
+  png_process_data(decoder_->pp, decoder_->info, (png_bytep)data, n);
+  if (complete()) {
+    delete decoder_;
+    decoder_ = 0;
+  }
+  flush_rows_();
+  return 0;
+#else
+  return -1;
+#endif // HAVE_LIBPNG && HAVE_LIBZ
+}
@@ -0,0 +1,78 @@
+//
+// Progressive image code for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <FL/Fl_Progressive_Image.H>
+#include <FL/Fl.H>
+
+#include <string.h>
+
+
+Fl_Progressive_Image::Fl_Progressive_Image()
+: Fl_RGB_Image(0, 0, 0),
+  handler_(0),
+  handler_data_(0),
+  complete_(0),
+  changed_y0_(0),
+  changed_y1_(0)
+{
+  alloc_array = 0;
+  array = 0;
+}
+
+// Allocate the pixel array, returns -1 if the image is too large
+int Fl_Progressive_Image::alloc_pixels_(int W, int H, int D) {
+  if (W <= 0 || H <= 0 || ((size_t)W) * H * D > max_size()) return -1;
+  uchar *pixels = new uchar[((size_t)W) * H * D];
+  memset(pixels, 0, ((size_t)W) * H * D);
+  w(W);
+  h(H);
+  d(D);
+  array = pixels;
+  alloc_array = 1;
+  return 0;
+}
+
+void Fl_Progressive_Image::rows_changed_(int y, int n) {
+  if (n <= 0) return;
+  if (changed_y0_ == changed_y1_) {
+    changed_y0_ = y;
+    changed_y1_ = y + n;
+  } else {
+    if (y < changed_y0_) changed_y0_ = y;
+    if (y + n > changed_y1_) changed_y1_ = y + n;
+  }
+}
+
+// Drop the cached copy of the image and tell the application which rows changed
+void Fl_Progressive_Image::flush_rows_() {
+  if (changed_y0_ == changed_y1_) return;
+  int y = changed_y0_, n = changed_y1_ - changed_y0_;
+  changed_y0_ = changed_y1_ = 0;
+  uncache();
+  if (handler_) handler_(this, y, n, handler_data_);
+}
+
+void Fl_Progressive_Image::fail_() {
+  uncache();
+  if (alloc_array) delete[] (uchar *)array;
+  array = 0;
+  alloc_array = 0;
+  w(0);
+  h(0);
+  d(0);
+  ld(ERR_FORMAT);
+  changed_y0_ = changed_y1_ = 0;
+}
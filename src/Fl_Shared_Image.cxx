@@ -24,7 +24,16 @@
 #include <FL/Fl_XBM_Image.H>
 #include <FL/Fl_XPM_Image.H>
 #include <FL/Fl_Preferences.H>
+#include <FL/Fl_Window.H>
 #include <FL/fl_draw.H>
+#include "Fl_System_Driver.H"
+
+#include <algorithm>
+#include <deque>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 //
 // Global class vars...
@@ -48,13 +57,119 @@ extern "C" {
 }
 
 
+//
+// Hash index of the shared image pool. images_ is kept unsorted while
+// images are added and removed and is only sorted when images() is called.
+//
+
+namespace {
+
+struct Pool_Key {
+  std::string name;
+  int w, h;
+  bool operator==(const Pool_Key &k) const {
+    return w == k.w && h == k.h && name == k.name;
+  }
+};
+
+struct Pool_Key_Hash {
+  size_t operator()(const Pool_Key &k) const {
+    size_t h = std::hash<std::string>()(k.name);
+    h ^= (size_t)k.w * 0x9E3779B1u + (h << 6) + (h >> 2);
+    h ^= (size_t)k.h * 0x85EBCA77u + (h << 6) + (h >> 2);
+    return h;
+  }
+};
+
+typedef std::list<Fl_Shared_Image*> Pool_LRU;
+
+struct Pool_Entry {
+  Pool_Key key;                 // key the image was added with
+  int index;                    // position in Fl_Shared_Image::images_
+  size_t bytes;                 // memory used by the image data
+  bool unused;                  // refcount is 0, image is in the LRU list
+  bool loading;                 // image is being loaded by get_async()
+  bool anonymous;               // named by get(Fl_RGB_Image*, int), can't be found again
+  Pool_LRU::iterator lru;       // position in the LRU list if unused
+};
+
+struct Pool_Index {
+  std::unordered_multimap<Pool_Key, Fl_Shared_Image*, Pool_Key_Hash> by_key;
+  std::unordered_multimap<std::string, Fl_Shared_Image*> originals;
+  std::unordered_map<Fl_Shared_Image*, Pool_Entry> entries;
+  Pool_LRU lru;                 // unused images, most recently used first
+  size_t used;                  // sum of all Pool_Entry::bytes
+  bool sorted;
+  Pool_Index() : used(0), sorted(true) { }
+};
+
+} // namespace
+
+// Allocated when the first image is added, deleted with the last one
+static Pool_Index *pool_index = 0;
+
+// Maximum memory used by the pool before unused images are deleted
+static size_t pool_budget = 0;
+
+// Estimate the memory used by the pixel data of an image.
+static size_t image_bytes(const Fl_Image *img) {
+  if (!img) return 0;
+  int d = img->d() ? (img->d() < 0 ? -img->d() : img->d()) : 1;
+  return (size_t)img->data_w() * img->data_h() * d;
+}
+
+template <class M, class K>
+static void erase_image(M &map, const K &key, Fl_Shared_Image *img) {
+  std::pair<typename M::iterator, typename M::iterator> r = map.equal_range(key);
+  for (typename M::iterator it = r.first; it != r.second; ++it) {
+    if (it->second == img) {
+      map.erase(it);
+      return;
+    }
+  }
+}
+
+// Return true if the image is still being loaded by get_async().
+static bool pool_loading(Fl_Shared_Image *img) {
+  if (!pool_index) return false;
+  std::unordered_map<Fl_Shared_Image*, Pool_Entry>::iterator it = pool_index->entries.find(img);
+  return it != pool_index->entries.end() && it->second.loading;
+}
+
+// Update the pool after get_async() loaded the image data.
+static void pool_loaded(Fl_Shared_Image *img) {
+  std::unordered_map<Fl_Shared_Image*, Pool_Entry>::iterator it = pool_index->entries.find(img);
+  if (it == pool_index->entries.end()) return;
+  Pool_Entry &entry = it->second;
+  entry.loading = false;
+  erase_image(pool_index->by_key, entry.key, img);
+  entry.key.w = img->data_w();
+  entry.key.h = img->data_h();
+  pool_index->by_key.insert(std::make_pair(entry.key, img));
+  pool_index->used -= entry.bytes;
+  entry.bytes = image_bytes(img->image());
+  pool_index->used += entry.bytes;
+  pool_index->sorted = false;
+}
+
+
 /**
  Returns the Fl_Shared_Image* array.
 
+ The array is sorted when this method is called. It is valid until the
+ next image is added or released.
+
  \return a pointer to an array of shared image pointers, sorted by name and size
  \see Fl_Shared_Image::num_images()
  */
 Fl_Shared_Image **Fl_Shared_Image::images() {
+  if (pool_index && !pool_index->sorted) {
+    qsort(images_, num_images_, sizeof(Fl_Shared_Image *),
+          (compare_func_t)compare);
+    for (int i = 0; i < num_images_; i++)
+      pool_index->entries[images_[i]].index = i;
+    pool_index->sorted = true;
+  }
   return images_;
 }
 
@@ -77,13 +192,9 @@ int Fl_Shared_Image::num_images() {
     -# Image width
     -# Image height
 
-  Binary search in a sorted array works only if we search for the same
-  parameters that were also used for sorting. No special cases are possible
-  here.
-
-  Fl_Shared_Image::find() requires a search for an element with a matching name
-  and the original_ flags set. This is not implemented via binary search, but
-  by a simple run of the array inside Fl_Shared_Image::find().
+  This is used to sort the array returned by Fl_Shared_Image::images().
+  Fl_Shared_Image::find() does not use it, it looks up images in a hash
+  table instead.
 
   \param[in] i0, i1 image pointer pointer for sorting
   \returns      Whether the images match or their relative sort order (see text).
@@ -148,10 +259,10 @@ Fl_Shared_Image::Fl_Shared_Image(const char *n,
 /**
   Adds a shared image to the image pool.
 
-  This \b protected method adds an image to the pool, an ordered list
-  of shared images. The pool is searched for a matching image whenever
-  one is requested, for instance with Fl_Shared_Image::get() or
-  Fl_Shared_Image::find().
+  This \b protected method adds an image to the pool, a hash table
+  of shared images indexed by name and size. The pool is searched for a
+  matching image whenever one is requested, for instance with
+  Fl_Shared_Image::get() or Fl_Shared_Image::find().
 
  This method does not increase or decrease reference counts!
 */
@@ -161,7 +272,8 @@ Fl_Shared_Image::add() {
 
   if (num_images_ >= alloc_images_) {
     // Allocate more memory...
-    temp = new Fl_Shared_Image *[alloc_images_ + 32];
+    int alloc = alloc_images_ ? alloc_images_ * 2 : 32;
+    temp = new Fl_Shared_Image *[alloc];
 
     if (alloc_images_) {
       memcpy(temp, images_, alloc_images_ * sizeof(Fl_Shared_Image *));
@@ -170,16 +282,31 @@ Fl_Shared_Image::add() {
     }
 
     images_       = temp;
-    alloc_images_ += 32;
+    alloc_images_ = alloc;
   }
 
+  if (!pool_index)
+    pool_index = new Pool_Index;
+
+  Pool_Entry entry;
+  entry.key.name = name_ ? name_ : "";
+  entry.key.w = data_w();
+  entry.key.h = data_h();
+  entry.index = num_images_;
+  entry.bytes = image_bytes(image_);
+  entry.unused = false;
+  entry.loading = false;
+  entry.anonymous = false;
+  pool_index->used += entry.bytes;
+  pool_index->by_key.insert(std::make_pair(entry.key, this));
+  if (original_ && name_)
+    pool_index->originals.insert(std::make_pair(entry.key.name, this));
+  pool_index->entries[this] = entry;
+
   images_[num_images_] = this;
   num_images_ ++;
-
-  if (num_images_ > 1) {
-    qsort(images_, num_images_, sizeof(Fl_Shared_Image *),
-          (compare_func_t)compare);
-  }
+  if (num_images_ > 1)
+    pool_index->sorted = false;
 }
 
 /**
@@ -215,12 +342,15 @@ Fl_Shared_Image::~Fl_Shared_Image() {
   Releases and possibly destroys (if refcount <= 0) a shared image.
 
   In the latter case, it will reorganize the shared image array
-  so that no hole will occur.
+  so that no hole will occur. If a cache size was set, the unused image
+  stays in the pool until it is needed again or evicted, unless it was
+  created by get(Fl_RGB_Image*, int): its generated name can't be found
+  again, and the application may delete its image data as soon as the
+  image is released.
+
+  \see cache_size(size_t)
 */
 void Fl_Shared_Image::release() {
-  int   i;      // Looping var...
-  Fl_Shared_Image *the_original = NULL;
-
 #ifdef SHIM_DEBUG
   printf("----> Fl_Shared_Image::release() %d %s %d %d\n", original_, name_, w(), h());
   print_pool();
@@ -230,6 +360,31 @@ void Fl_Shared_Image::release() {
   refcount_ --;
   if (refcount_ > 0) return;
 
+  // Keep the unused image in the pool if a cache size was set, but only
+  // if it owns its image data and can be found by its name again
+  if (pool_budget && pool_index && alloc_image_) {
+    std::unordered_map<Fl_Shared_Image*, Pool_Entry>::iterator it = pool_index->entries.find(this);
+    if (it != pool_index->entries.end() && !it->second.anonymous) {
+      pool_index->lru.push_front(this);
+      it->second.lru = pool_index->lru.begin();
+      it->second.unused = true;
+      trim_cache_();
+      return;
+    }
+  }
+
+  remove_();
+}
+
+/**
+  Removes the image from the pool and deletes it.
+
+  This \b protected method is called when the reference count of the image
+  drops to zero, or when an unused image is evicted from the cache.
+*/
+void Fl_Shared_Image::remove_() {
+  Fl_Shared_Image *the_original = NULL;
+
   // If this image is not the original, find the original image and make sure
   // to delete its reference counter as well at the end of this method.
   if (!original()) {
@@ -241,70 +396,167 @@ void Fl_Shared_Image::release() {
     }
   }
 
-  for (i = 0; i < num_images_; i ++) {
-    if (images_[i] == this) {
-      num_images_ --;
+  unpool_();
+  delete this;
 
-      if (i < num_images_) {
-        memmove(images_ + i, images_ + i + 1,
-                (num_images_ - i) * sizeof(Fl_Shared_Image *));
-      }
+#ifdef SHIM_DEBUG
+  printf("<---- Fl_Shared_Image::release() %d %s %d %d\n", original_, name_, w(), h());
+  print_pool();
+  printf("\n");
+#endif
 
-      break;
+  // Release one reference count in the original image as well.
+  if (the_original)
+    the_original->release();
+}
+
+/**
+  Removes the image from the pool without deleting it.
+
+  This \b protected method is called by remove_(), and when get_async()
+  fails to load an image: the placeholder is then no longer found, and it
+  is deleted when it is released.
+*/
+void Fl_Shared_Image::unpool_() {
+  // Remove the image from the pool, the last image takes its place
+  std::unordered_map<Fl_Shared_Image*, Pool_Entry>::iterator it;
+  if (pool_index && (it = pool_index->entries.find(this)) != pool_index->entries.end()) {
+    int i = it->second.index;
+    if (it->second.unused)
+      pool_index->lru.erase(it->second.lru);
+    pool_index->used -= it->second.bytes;
+    erase_image(pool_index->by_key, it->second.key, this);
+    erase_image(pool_index->originals, it->second.key.name, this);
+    pool_index->entries.erase(it);
+    num_images_ --;
+    if (i < num_images_) {
+      images_[i] = images_[num_images_];
+      pool_index->entries[images_[i]].index = i;
+      pool_index->sorted = false;
     }
   }
 
-  delete this;
-
   if (num_images_ == 0 && images_) {
     delete[] images_;
 
     images_       = 0;
     alloc_images_ = 0;
+
+    delete pool_index;
+    pool_index = 0;
   }
-#ifdef SHIM_DEBUG
-  printf("<---- Fl_Shared_Image::release() %d %s %d %d\n", original_, name_, w(), h());
-  print_pool();
-  printf("\n");
-#endif
+}
 
-  // Release one reference count in the original image as well.
-  if (the_original)
-    the_original->release();
+/**
+  Sets the maximum memory used by the shared image pool.
+
+  By default, a shared image is deleted as soon as its reference count
+  drops to zero. If a cache size is set, unused images stay in the pool so
+  that Fl_Shared_Image::get() and Fl_Shared_Image::find() can return them
+  again without loading the file. When the memory used by all images in the
+  pool exceeds \p bytes, the least recently used unused images are removed
+  from the device caches (see uncache()) and deleted until the pool fits
+  again. Images that are still referenced are never deleted, hence the
+  pool can still grow beyond this size.
+
+  The memory of an image is estimated from its pixel data as
+  data_w() * data_h() * d() bytes.
+
+  Setting the cache size to 0 (the default) deletes all unused images.
+
+  \param[in] bytes maximum memory used by the pool, or 0
+  \see cache_used()
+  \since 1.5.0
+*/
+void Fl_Shared_Image::cache_size(size_t bytes) {
+  pool_budget = bytes;
+  trim_cache_();
 }
 
-/** Reloads the shared image from disk. */
-void Fl_Shared_Image::reload() {
-  // Load image from disk...
+/**
+  Returns the maximum memory used by the shared image pool.
+  \see cache_size(size_t)
+  \since 1.5.0
+*/
+size_t Fl_Shared_Image::cache_size() {
+  return pool_budget;
+}
+
+/**
+  Returns the memory used by all images in the pool, including unused
+  images that are kept in the cache.
+  \see cache_size(size_t)
+  \since 1.5.0
+*/
+size_t Fl_Shared_Image::cache_used() {
+  return pool_index ? pool_index->used : 0;
+}
+
+/**
+  Deletes the least recently used unused images until the pool fits into
+  the cache size.
+*/
+void Fl_Shared_Image::trim_cache_() {
+  while (pool_index && !pool_index->lru.empty() &&
+         (!pool_budget || pool_index->used > pool_budget)) {
+    Fl_Shared_Image *img = pool_index->lru.back();
+    img->uncache();
+    img->remove_();
+  }
+}
+
+/**
+  Loads an image file with the built-in loaders or the image handlers.
+
+  This \b protected method does not access the image pool or the list of
+  image handlers, so it can also be called from a background thread with
+  a copy of the handlers made in the main thread.
+
+  \param[in] name name of the image file
+  \param[in] handlers, num_handlers the image handlers to try
+  \return the new image, or NULL if the file can't be read or has an
+        unknown format
+*/
+Fl_Image *Fl_Shared_Image::load_(const char *name, const Fl_Shared_Handler *handlers,
+                                 int num_handlers) {
   int           i;              // Looping var
   int           count = 0;      // number of bytes read from image header
   FILE          *fp;            // File pointer
   uchar         header[64];     // Buffer for auto-detecting files
   Fl_Image      *img;           // New image
 
-  if (!name_) return;
-
-  if ((fp = fl_fopen(name_, "rb")) != NULL) {
+  if ((fp = fl_fopen(name, "rb")) != NULL) {
     count = (int)fread(header, 1, sizeof(header), fp);
     fclose(fp);
     if (count == 0)
-      return;
+      return NULL;
   } else {
-    return;
+    return NULL;
   }
 
   // Load the image as appropriate...
   if (count >= 7 && memcmp(header, "#define", 7) == 0) // XBM file
-    img = new Fl_XBM_Image(name_);
+    img = new Fl_XBM_Image(name);
   else if (count >= 9 && memcmp(header, "/* XPM */", 9) == 0) // XPM file
-    img = new Fl_XPM_Image(name_);
+    img = new Fl_XPM_Image(name);
   else {
     // Not a standard format; try an image handler...
-    for (i = 0, img = 0; i < num_handlers_; i ++) {
-      img = (handlers_[i])(name_, header, count);
+    for (i = 0, img = 0; i < num_handlers; i ++) {
+      img = (handlers[i])(name, header, count);
       if (img) break;
     }
   }
+  return img;
+}
+
+/** Reloads the shared image from disk. */
+void Fl_Shared_Image::reload() {
+  // Load image from disk...
+  Fl_Image      *img;           // New image
+
+  if (!name_) return;
+
+  img = load_(name_, handlers_, num_handlers_);
 
   if (img) {
     if (alloc_image_) delete image_;
@@ -445,7 +697,8 @@ Fl_Shared_Image::desaturate() {
  */
 void Fl_Shared_Image::draw(int X, int Y, int W, int H, int cx, int cy) {
   if (!image_) {
-    Fl_Image::draw(X, Y, W, H, cx, cy);
+    if (!pool_loading(this)) // draw nothing until get_async() is done
+      Fl_Image::draw(X, Y, W, H, cx, cy);
     return;
   }
   // transiently set the drawing size of image_ to that of the shared image
@@ -467,7 +720,7 @@ void Fl_Shared_Image::uncache()
 
 /** Finds a shared image from its name and size specifications.
 
-  This uses a binary search in the image cache.
+  This uses a hash table lookup in the image cache.
 
   If the image \p name exists with the exact width \p W and height \p H,
   then it is returned.
@@ -482,11 +735,7 @@ void Fl_Shared_Image::uncache()
   An image is marked \p original if it was directly loaded from a file or
   from memory as opposed to copied and resized images.
 
-  This comparison is used in Fl_Shared_Image::find() to find an image that
-  matches the requested one or to find the position where a new image
-  should be entered into the sorted list of shared images.
-
-  It is used in two steps by Fl_Shared_Image::add():
+  Fl_Shared_Image::get() uses this method in two steps:
 
   -# search with exact width and height
   -# if not found, search again with width = 0 (and height = 0)
@@ -496,44 +745,33 @@ void Fl_Shared_Image::uncache()
   marked \p original with the same name, regardless of width and height.
 */
 Fl_Shared_Image* Fl_Shared_Image::find(const char *name, int W, int H) {
-  if (num_images_) {
+  if (num_images_ && pool_index && name) {
+    Fl_Shared_Image *img = 0;
     if (W) {
-      Fl_Shared_Image *key;     // Image key
-      Fl_Shared_Image **match;  // Matching image
-
-      key = new Fl_Shared_Image();
-      key->name_ = new char[strlen(name) + 1];
-      strcpy((char *)key->name_, name);
-      key->w(W);
-      key->h(H);
-
-      match = (Fl_Shared_Image **)bsearch(&key, images_, num_images_,
-                                          sizeof(Fl_Shared_Image *),
-                                          (compare_func_t)compare);
-
-      delete key;
-
-      if (match) {
-        (*match)->refcount_ ++;
-        return *match;
-      }
+      Pool_Key key;
+      key.name = name;
+      key.w = W;
+      key.h = H;
+      std::unordered_multimap<Pool_Key, Fl_Shared_Image*, Pool_Key_Hash>::iterator
+        it = pool_index->by_key.find(key);
+      if (it != pool_index->by_key.end())
+        img = it->second;
     } else {
-      // if no width was given we need to find the original. The list is sorted
-      // by name, width, and height, but we need to find the item by name with
-      // the original_ flags set, no matter how wide, so binary search does not
-      // work here.
-      int i;
-      for (i = 0; i < num_images_; ++i) {
-        // If there are thousands of images and running the array becomes
-        // inefficient, we can hand implement a binary search by name, and then
-        // search back and forth from that location for the member with the
-        // original_ flag set.
-        Fl_Shared_Image *img = images_[i];
-        if (img->original_ && img->name_ && (strcmp(img->name_, name) == 0)) {
-          img->refcount_++;
-          return img;
-        }
+      // if no width was given we need to find the original, no matter how
+      // wide, so this uses a separate table of original images by name
+      std::unordered_multimap<std::string, Fl_Shared_Image*>::iterator
+        it = pool_index->originals.find(name);
+      if (it != pool_index->originals.end())
+        img = it->second;
+    }
+    if (img) {
+      if (img->refcount_ == 0) {        // revive an image from the cache
+        Pool_Entry &entry = pool_index->entries[img];
+        pool_index->lru.erase(entry.lru);
+        entry.unused = false;
       }
+      img->refcount_ ++;
+      return img;
     }
   }
   return NULL;
@@ -580,6 +818,9 @@ Fl_Shared_Image* Fl_Shared_Image::get(const char *name, int W, int H) {
   Fl_Shared_Image *temp;
   bool temp_referenced = false;
 
+  // If get_async() is still loading the image, load it now
+  async_wait_(name);
+
   // Find an image by the requested size
   // ::find() increments the ref count for us
   if ((temp = find(name, W, H)) != NULL)
@@ -631,9 +872,284 @@ Fl_Shared_Image *Fl_Shared_Image::get(Fl_RGB_Image *rgb, int own_it)
   Fl_Shared_Image *shared = new Fl_Shared_Image(Fl_Preferences::newUUID(), rgb);
   shared->alloc_image_ = own_it;
   shared->add();
+  pool_index->entries[shared].anonymous = true; // never cache it after release
   return shared;
 }
 
+//
+// Background loading for get_async(). Jobs are started in the main thread
+// and at most async_threads images are loaded at the same time.
+//
+
+namespace {
+
+struct Async_Job {
+  Fl_Shared_Image *image;       // the original placeholder, referenced by the job
+  std::vector<Fl_Shared_Image*> copies; // resized placeholders, referenced by the job
+  std::string name;             // file to load
+  std::vector<Fl_Shared_Handler> handlers; // image handlers when the job was queued
+  Fl_Image *result;             // loaded image, or NULL
+  bool threaded;                // loaded in a background thread
+  bool done;                    // get() loaded the image in the meantime
+};
+
+} // namespace
+
+static const int async_threads = 4;
+static int async_running = 0;
+
+static std::deque<Async_Job*> &async_queue() {
+  static std::deque<Async_Job*> q;
+  return q;
+}
+
+// Jobs whose placeholders did not receive their image yet, by file name
+static std::unordered_map<std::string, Async_Job*> &async_jobs() {
+  static std::unordered_map<std::string, Async_Job*> jobs;
+  return jobs;
+}
+
+// Redraw w and all its children that display img.
+static void redraw_image_users(Fl_Widget *w, Fl_Image *img) {
+  if (w->image() == img || w->deimage() == img)
+    w->redraw();
+  Fl_Group *g = w->as_group();
+  if (g) {
+    for (int i = 0; i < g->children(); i++)
+      redraw_image_users(g->child(i), img);
+  }
+}
+
+/**
+  Starts as many queued get_async() jobs as possible.
+*/
+void Fl_Shared_Image::async_start_() {
+  std::deque<Async_Job*> &q = async_queue();
+  while (async_running < async_threads && !q.empty()) {
+    Async_Job *job = q.front();
+    job->threaded = true;
+    if (Fl::system_driver()->create_thread(async_run_, job) != 0) {
+      // No threads, load one image per timeout so the UI stays responsive
+      if (!Fl::has_timeout(async_timeout_))
+        Fl::add_timeout(0.0, async_timeout_);
+      return;
+    }
+    q.pop_front();
+    async_running++;
+  }
+}
+
+/**
+  Loads the next queued get_async() job in the main thread.
+*/
+void Fl_Shared_Image::async_timeout_(void *) {
+  std::deque<Async_Job*> &q = async_queue();
+  if (q.empty()) return;
+  Async_Job *job = q.front();
+  q.pop_front();
+  job->threaded = false;
+  async_run_(job);
+}
+
+/**
+  Loads the image of a get_async() job.
+
+  This \b protected method is the thread function used by get_async().
+  It must not access the image pool or any widgets. A background thread
+  hands the job back to the main thread with Fl::awake().
+*/
+void Fl_Shared_Image::async_run_(void *data) {
+  Async_Job *job = (Async_Job *)data;
+  job->result = load_(job->name.c_str(),
+                      job->handlers.empty() ? NULL : &job->handlers[0],
+                      (int)job->handlers.size());
+  if (job->threaded)
+    Fl::awake(async_done_, job);
+  else
+    async_done_(job);
+}
+
+/**
+  Hands an image loaded by async_run_() to the main thread.
+
+  This \b protected method is called in the main thread. It installs the
+  image unless get() loaded it in the meantime, deletes the job, and starts
+  the next queued job.
+*/
+void Fl_Shared_Image::async_done_(void *data) {
+  Async_Job *job = (Async_Job *)data;
+  if (job->threaded)
+    async_running--;
+  if (job->done)
+    delete job->result;
+  else
+    async_finish_(job, job->result);
+  delete job;
+  trim_cache_();
+  async_start_();
+}
+
+/**
+  Installs the image of a get_async() job in its placeholders.
+
+  This \b protected method is called in the main thread. The original
+  placeholder receives \p result, and every resized placeholder a copy
+  of it with its size. If \p result is NULL, the placeholders are removed
+  from the pool, so that they are not found again, and they are deleted
+  when the application releases them. All widgets that use one of the
+  placeholders as their image() or deimage() are redrawn. Finally, the
+  references held by the job are released.
+*/
+void Fl_Shared_Image::async_finish_(void *data, Fl_Image *result) {
+  Async_Job *job = (Async_Job *)data;
+  Fl_Shared_Image *img = job->image;
+  async_jobs().erase(job->name);
+  job->done = true;
+  if (result) {
+    img->image_ = result;
+    img->alloc_image_ = 1;
+    img->update();
+    pool_loaded(img);
+  } else {
+    img->unpool_();
+  }
+  for (size_t i = 0; i < job->copies.size(); i++) {
+    Fl_Shared_Image *copy = job->copies[i];
+    if (result) {
+      copy->image_ = result->copy(copy->w(), copy->h());
+      copy->alloc_image_ = 1;
+      copy->update();
+      pool_loaded(copy);
+    } else {
+      // remove_() must not release the original by name, release it here
+      copy->unpool_();
+      copy->original_ = 1;
+      img->release();
+    }
+  }
+  for (Fl_Window *win = Fl::first_window(); win; win = Fl::next_window(win)) {
+    redraw_image_users(win, img);
+    for (size_t i = 0; i < job->copies.size(); i++)
+      redraw_image_users(win, job->copies[i]);
+  }
+  for (size_t i = 0; i < job->copies.size(); i++)
+    job->copies[i]->release();
+  img->release();
+}
+
+/**
+  Loads an image that get_async() is still loading in the main thread.
+
+  This \b protected method is used by get() so that it never returns
+  an empty placeholder. The result of the background thread, if any, is
+  discarded later.
+*/
+void Fl_Shared_Image::async_wait_(const char *name) {
+  std::unordered_map<std::string, Async_Job*>::iterator it;
+  if (!name || (it = async_jobs().find(name)) == async_jobs().end())
+    return;
+  Async_Job *job = it->second;
+  async_finish_(job, load_(name, handlers_, num_handlers_));
+  std::deque<Async_Job*> &q = async_queue();
+  std::deque<Async_Job*>::iterator qi = std::find(q.begin(), q.end(), job);
+  if (qi != q.end()) {          // not started yet
+    q.erase(qi);
+    delete job;
+  }
+}
+
+/**
+  Find or load an image without blocking the user interface.
+
+  This works like Fl_Shared_Image::get(const char *name, int W, int H),
+  except that an image that is not yet in the pool is loaded in a
+  background thread. get_async() then immediately returns an empty
+  placeholder image that is already in the pool with the given \p name.
+  The placeholder draws nothing until it is loaded. When the image is
+  loaded, the placeholder receives the image data, and all widgets that
+  use it as their image() or deimage() are redrawn.
+
+  If \p W and \p H are given, the placeholder is a resized copy with this
+  size, which receives a copy of the loaded image, and the original image
+  is added to the pool as well, like with get().
+
+  If the image can't be loaded, the placeholder stays empty and draws like
+  an empty Fl_Image. It is removed from the pool, so that a later get() or
+  get_async() tries to load the file again.
+
+  Calling get() for an image that is still being loaded loads the image
+  in the main thread, it never returns a placeholder.
+
+  Background threads require that the main thread called Fl::lock() before,
+  see \ref advanced_multithreading. Otherwise, or if the platform does not
+  support threads, the images are loaded one by one in the main thread
+  from a timeout callback.
+
+  Image handlers added with add_handler() are called in the background
+  threads as well, so they must not access widgets or the image pool.
+
+  You should release() the image when you're done with it.
+
+  \param name name of the image
+  \param W, H desired size, or 0 for the size of the image
+  \return the image or its placeholder, never NULL
+
+  \see Fl_Shared_Image::get(const char *name, int W, int H)
+  \since 1.5.0
+*/
+Fl_Shared_Image *Fl_Shared_Image::get_async(const char *name, int W, int H) {
+  Fl_Shared_Image *img;
+  if ((img = find(name, W, H)) != NULL)
+    return img;
+
+  Async_Job *job;
+  std::unordered_map<std::string, Async_Job*>::iterator it = async_jobs().find(name);
+  if (it != async_jobs().end()) {
+    job = it->second;           // still loading, add a resized placeholder
+  } else {
+    if ((img = find(name)) != NULL) {
+      img->release();
+      return get(name, W, H);
+    }
+
+    // Create the placeholder and add it to the pool, the job references it
+    img = new Fl_Shared_Image();
+    img->name_ = new char[strlen(name) + 1];
+    strcpy((char *)img->name_, name);
+    img->original_ = 1;
+    img->add();
+    pool_index->entries[img].loading = true;
+
+    job = new Async_Job;
+    job->image = img;
+    job->name = name;
+    job->handlers.assign(handlers_, handlers_ + num_handlers_);
+    job->result = 0;
+    job->threaded = false;
+    job->done = false;
+    async_jobs()[job->name] = job;
+    async_queue().push_back(job);
+    async_start_();
+    if (!W || !H) {
+      img->refcount_++;
+      return img;
+    }
+  }
+
+  // Create a resized placeholder, it references the original like copy_()
+  img = new Fl_Shared_Image();
+  img->name_ = new char[strlen(name) + 1];
+  strcpy((char *)img->name_, name);
+  img->w(W);
+  img->h(H);
+  img->add();
+  pool_index->entries[img].loading = true;
+  img->refcount_++;             // released in async_finish_()
+  job->image->refcount_++;
+  job->copies.push_back(img);
+  return img;
+}
+
 /** Adds a shared image handler, which is basically a test function
   for adding new image formats.
 
@@ -646,6 +1162,9 @@ Fl_Shared_Image *Fl_Shared_Image::get(Fl_RGB_Image *rgb, int own_it)
   handlers - unless you need to override a known image file type which
   should be rare.
 
+  Handlers must be added and removed in the main thread. get_async() passes
+  a copy of the current handlers to its background threads.
+
   \see Fl_Shared_Handler for more information of the function you need
     to define.
 */
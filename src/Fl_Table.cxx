@@ -19,12 +19,58 @@
 #include <FL/Fl_Table.H>
 #include <FL/Fl.H>
 #include <FL/fl_draw.H>
+#include "Fl_Table_Size_Index.H"
 
 #include <sys/types.h>
 #include <string.h>             // memcpy
 #include <stdio.h>              // fprintf
 #include <stdlib.h>             // realloc/free
+#include <algorithm>            // std::min
 
+// Fl_Scrollbar::value() is an int. If a table can be scrolled by more pixels
+// than this, its scrollbar gets this range and the position is scaled.
+static const long long max_scrollbar_range = 1 << 30;
+
+// Convert a scroll position in pixels to a scrollbar value
+static double scrollbar_value(long long pos, long long range) {
+  if (range <= max_scrollbar_range) return (double)pos;
+  return (double)pos * max_scrollbar_range / range;
+}
+
+// Convert a scrollbar value to a scroll position in pixels
+static long long scroll_pixels(double value, long long range) {
+  if (range <= max_scrollbar_range) return (long long)value;
+  return (long long)(value * range / max_scrollbar_range + 0.5);
+}
+
+// Limit the distance of a cell far outside the window to an int coordinate
+static int scroll_offset(long long d) {
+  if (d > max_scrollbar_range) return (int)max_scrollbar_range;
+  if (d < -max_scrollbar_range) return (int)-max_scrollbar_range;
+  return (int)d;
+}
+
+long long Fl_Table::_vscroll_pos() {
+  return scroll_pixels(vscrollbar->Fl_Slider::value(), table_h - tih);
+}
+
+long long Fl_Table::_hscroll_pos() {
+  return scroll_pixels(hscrollbar->Fl_Slider::value(), table_w - tiw);
+}
+
+void Fl_Table::_vscroll_pos(long long pos) {
+  long long range = table_h - tih;
+  if ( pos > range ) pos = range;
+  if ( pos < 0 ) pos = 0;
+  vscrollbar->Fl_Slider::value(scrollbar_value(pos, range));
+}
+
+void Fl_Table::_hscroll_pos(long long pos) {
+  long long range = table_w - tiw;
+  if ( pos > range ) pos = range;
+  if ( pos < 0 ) pos = 0;
+  hscrollbar->Fl_Slider::value(scrollbar_value(pos, range));
+}
 
 /** Sets the vertical scroll position so 'row' is at the top,
     and causes the screen to redraw.
@@ -34,11 +80,7 @@ void Fl_Table::row_position(int row) {
   if ( row < 0 ) row = 0;
   else if ( row >= rows() ) row = rows() - 1;
   if ( table_h <= tih ) return;                 // don't scroll if table smaller than window
-  double newtop = row_scroll_position(row);
-  if ( newtop > vscrollbar->maximum() ) {
-    newtop = vscrollbar->maximum();
-  }
-  vscrollbar->Fl_Slider::value(newtop);
+  _vscroll_pos(row_scroll_position(row));
   table_scrolled();
   redraw();
   _row_position = row;  // HACK: override what table_scrolled() came up with
@@ -53,11 +95,7 @@ void Fl_Table::col_position(int col) {
   if ( col < 0 ) col = 0;
   else if ( col >= cols() ) col = cols() - 1;
   if ( table_w <= tiw ) return;         // don't scroll if table smaller than window
-  double newleft = col_scroll_position(col);
-  if ( newleft > hscrollbar->maximum() ) {
-    newleft = hscrollbar->maximum();
-  }
-  hscrollbar->Fl_Slider::value(newleft);
+  _hscroll_pos(col_scroll_position(col));
   table_scrolled();
   redraw();
   _col_position = col;  // HACK: override what table_scrolled() came up with
@@ -66,39 +104,15 @@ void Fl_Table::col_position(int col) {
 /**
   Returns the scroll position (in pixels) of the specified 'row'.
 */
-long Fl_Table::row_scroll_position(int row) {
-  int startrow = 0;
-  long scroll = 0;
-  // OPTIMIZATION:
-  //     Attempt to use precomputed row scroll position
-  //
-  if ( toprow_scrollpos != -1 && row >= toprow ) {
-    scroll = toprow_scrollpos;
-    startrow = toprow;
-  }
-  for ( int t=startrow; t<row; t++ ) {
-    scroll += row_height(t);
-  }
-  return(scroll);
+long long Fl_Table::row_scroll_position(int row) {
+  return _rowheights->position(row);
 }
 
 /**
   Returns the scroll position (in pixels) of the specified column 'col'.
 */
-long Fl_Table::col_scroll_position(int col) {
-  int startcol = 0;
-  long scroll = 0;
-  // OPTIMIZATION:
-  //     Attempt to use precomputed row scroll position
-  //
-  if ( leftcol_scrollpos != -1 && col >= leftcol ) {
-    scroll = leftcol_scrollpos;
-    startcol = leftcol;
-  }
-  for ( int t=startcol; t<col; t++ ) {
-    scroll += col_width(t);
-  }
-  return(scroll);
+long long Fl_Table::col_scroll_position(int col) {
+  return _colwidths->position(col);
 }
 
 /**
@@ -145,8 +159,8 @@ Fl_Table::Fl_Table(int X, int Y, int W, int H, const char *l) : Fl_Group(X,Y,W,H
   _scrollbar_size   = 0;
   flags_            = 0;        // TABCELLNAV off
 
-  _colwidths        = new std::vector<int>;  // column widths in pixels
-  _rowheights       = new std::vector<int>;  // row heights in pixels
+  _colwidths        = new Fl_Table_Size_Index;  // column widths in pixels
+  _rowheights       = new Fl_Table_Size_Index;  // row heights in pixels
 
   box(FL_THIN_DOWN_FRAME);
 
@@ -216,15 +230,15 @@ int Fl_Table::row_size() {
 */
 void Fl_Table::row_height(int row, int height) {
   if ( row < 0 ) return;
-  if ( row < row_size() && (*_rowheights)[row] == height ) {
+  if ( row < row_size() && _rowheights->get(row) == height ) {
     return;             // OPTIMIZATION: no change? avoid redraw
   }
   // Add row heights, even if none yet
   int now_size = row_size();
   if (row >= now_size) {
-    _rowheights->resize(row, height);
+    _rowheights->resize(row+1, height);
   }
-  (*_rowheights)[row] = height;
+  _rowheights->set(row, height);
   table_resized();
   if ( row <= botrow ) {        // OPTIMIZATION: only redraw if onscreen or above screen
     redraw();
@@ -243,7 +257,7 @@ void Fl_Table::row_height(int row, int height) {
 void Fl_Table::col_width(int col, int width)
 {
   if ( col < 0 ) return;
-  if ( col < col_size() && (*_colwidths)[col] == width ) {
+  if ( col < col_size() && _colwidths->get(col) == width ) {
     return;                     // OPTIMIZATION: no change? avoid redraw
   }
   // Add column widths, even if none yet
@@ -251,7 +265,7 @@ void Fl_Table::col_width(int col, int width)
   if ( col >= now_size ) {
     _colwidths->resize(col+1, width);
   }
-  (*_colwidths)[col] = width;
+  _colwidths->set(col, width);
   table_resized();
   if ( col <= rightcol ) {      // OPTIMIZATION: only redraw if onscreen or to the left
     redraw();
@@ -262,6 +276,42 @@ void Fl_Table::col_width(int col, int width)
   }
 }
 
+/**
+  Convenience method to set the height of all rows to the
+  same value, in pixels. The screen is redrawn.
+
+  Unless callback() is invoked for every row (when() is FL_WHEN_CHANGED),
+  this takes constant time regardless of the number of rows, and the row
+  heights use no memory until a row is given a different height.
+*/
+void Fl_Table::row_height_all(int height) {
+  if ( (Fl_Widget::callback() && when() & FL_WHEN_CHANGED) || row_size() != rows() ) {
+    for ( int r=0; r<rows(); r++ ) {
+      row_height(r, height);
+    }
+    return;
+  }
+  _rowheights->fill(height);
+  table_resized();
+  redraw();
+}
+
+/**
+  Convenience method to set the width of all columns to the
+  same value, in pixels. The screen is redrawn.
+*/
+void Fl_Table::col_width_all(int width) {
+  if ( (Fl_Widget::callback() && when() & FL_WHEN_CHANGED) || col_size() != cols() ) {
+    for ( int c=0; c<cols(); c++ ) {
+      col_width(c, width);
+    }
+    return;
+  }
+  _colwidths->fill(width);
+  table_resized();
+  redraw();
+}
+
 /**
   Return specified row/col values R and C to within the table's
   current row/col limits.
@@ -326,6 +376,22 @@ void Fl_Table::get_bounds(TableContext context, int &X, int &Y, int &W, int &H)
   //NOTREACHED
 }
 
+// Returns the row at window position Y, or -1 if there is none
+int Fl_Table::_find_row(int Y) {
+  long long pos = (long long)Y - tiy + _vscroll_pos();
+  if ( pos < 0 ) return(-1);
+  int R = _rowheights->find(pos);
+  return((R < _rows) ? R : -1);
+}
+
+// Returns the column at window position X, or -1 if there is none
+int Fl_Table::_find_col(int X) {
+  long long pos = (long long)X - tix + _hscroll_pos();
+  if ( pos < 0 ) return(-1);
+  int C = _colwidths->find(pos);
+  return((C < _cols) ? C : -1);
+}
+
 /**
   Find row/col for the recent mouse event.
   Returns the context, and the row/column values in R/C.
@@ -341,21 +407,21 @@ Fl_Table::TableContext Fl_Table::cursor2rowcol(int &R, int &C, ResizeFlag &resiz
     // Inside a row heading?
     get_bounds(CONTEXT_ROW_HEADER, X, Y, W, H);
     if ( Fl::event_inside(X, Y, W, H) ) {
-      // Scan visible rows until found
-      for ( R = toprow; R <= botrow; R++ ) {
+      // Find row under mouse
+      R = _find_row(Fl::event_y());
+      if ( R >= 0 ) {
         find_cell(CONTEXT_ROW_HEADER, R, 0, X, Y, W, H);
-        if ( Fl::event_y() >= Y && Fl::event_y() < (Y+H) ) {
-          // Found row?
-          //     If cursor over resize boundary, and resize enabled,
-          //     enable the appropriate resize flag.
-          //
-          if ( row_resize() ) {
-            if ( Fl::event_y() <= (Y+3-0) ) { resizeflag = RESIZE_ROW_ABOVE; }
-            if ( Fl::event_y() >= (Y+H-3) ) { resizeflag = RESIZE_ROW_BELOW; }
-          }
-          return(CONTEXT_ROW_HEADER);
+        // Found row?
+        //     If cursor over resize boundary, and resize enabled,
+        //     enable the appropriate resize flag.
+        //
+        if ( row_resize() ) {
+          if ( Fl::event_y() <= (Y+3-0) ) { resizeflag = RESIZE_ROW_ABOVE; }
+          if ( Fl::event_y() >= (Y+H-3) ) { resizeflag = RESIZE_ROW_BELOW; }
         }
+        return(CONTEXT_ROW_HEADER);
       }
+      R = 0;
       // Must be in row header dead zone
       return(CONTEXT_NONE);
     }
@@ -365,38 +431,35 @@ Fl_Table::TableContext Fl_Table::cursor2rowcol(int &R, int &C, ResizeFlag &resiz
     // Inside a column heading?
     get_bounds(CONTEXT_COL_HEADER, X, Y, W, H);
     if ( Fl::event_inside(X, Y, W, H) ) {
-      // Scan visible columns until found
-      for ( C = leftcol; C <= rightcol; C++ ) {
+      // Find column under mouse
+      C = _find_col(Fl::event_x());
+      if ( C >= 0 ) {
         find_cell(CONTEXT_COL_HEADER, 0, C, X, Y, W, H);
-        if ( Fl::event_x() >= X && Fl::event_x() < (X+W) ) {
-          // Found column?
-          //     If cursor over resize boundary, and resize enabled,
-          //     enable the appropriate resize flag.
-          //
-          if ( col_resize() ) {
-            if ( Fl::event_x() <= (X+3-0) ) { resizeflag = RESIZE_COL_LEFT; }
-            if ( Fl::event_x() >= (X+W-3) ) { resizeflag = RESIZE_COL_RIGHT; }
-          }
-          return(CONTEXT_COL_HEADER);
+        // Found column?
+        //     If cursor over resize boundary, and resize enabled,
+        //     enable the appropriate resize flag.
+        //
+        if ( col_resize() ) {
+          if ( Fl::event_x() <= (X+3-0) ) { resizeflag = RESIZE_COL_LEFT; }
+          if ( Fl::event_x() >= (X+W-3) ) { resizeflag = RESIZE_COL_RIGHT; }
         }
+        return(CONTEXT_COL_HEADER);
       }
+      C = 0;
       // Must be in column header dead zone
       return(CONTEXT_NONE);
     }
   }
   // Mouse somewhere in table?
-  //     Scan visible r/c's until we find it.
+  //     Find row and column under mouse.
   //
   if ( Fl::event_inside(tox, toy, tow, toh) ) {
-    for ( R = toprow; R <= botrow; R++ ) {
+    R = _find_row(Fl::event_y());
+    C = _find_col(Fl::event_x());
+    if ( R >= 0 && C >= 0 ) {
       find_cell(CONTEXT_CELL, R, C, X, Y, W, H);
-      if ( Fl::event_y() < Y ) break;           // OPT: thanks lars
-      if ( Fl::event_y() >= (Y+H) ) continue;   // OPT: " "
-      for ( C = leftcol; C <= rightcol; C++ ) {
-        find_cell(CONTEXT_CELL, R, C, X, Y, W, H);
-        if ( Fl::event_inside(X, Y, W, H) ) {
-          return(CONTEXT_CELL);                 // found it
-        }
+      if ( Fl::event_inside(X, Y, W, H) ) {
+        return(CONTEXT_CELL);                   // found it
       }
     }
     // Must be in a dead zone of the table
@@ -418,8 +481,8 @@ int Fl_Table::find_cell(TableContext context, int R, int C, int &X, int &Y, int
     X=Y=W=H=0;
     return(-1);
   }
-  X = (int)col_scroll_position(C) - hscrollbar->value() + tix;
-  Y = (int)row_scroll_position(R) - vscrollbar->value() + tiy;
+  X = scroll_offset(col_scroll_position(C) - _hscroll_pos()) + tix;
+  Y = scroll_offset(row_scroll_position(R) - _vscroll_pos()) + tiy;
   W = col_width(C);
   H = row_height(R);
 
@@ -477,14 +540,14 @@ void Fl_Table::_auto_drag_cb() {
   if (lx > x() + w() - 20) {
     Fl::e_x = x() + w() - 20;
     if (hscrollbar->visible())
-      ((Fl_Slider*)hscrollbar)->value(hscrollbar->clamp(hscrollbar->value() + 30));
+      _hscroll_pos(_hscroll_pos() + 30);
     hscrollbar->do_callback();
     _dragging_x = Fl::e_x - 30;
   }
   else if (lx < (x() + row_header_width())) {
     Fl::e_x = x() + row_header_width() + 1;
     if (hscrollbar->visible()) {
-      ((Fl_Slider*)hscrollbar)->value(hscrollbar->clamp(hscrollbar->value() - 30));
+      _hscroll_pos(_hscroll_pos() - 30);
     }
     hscrollbar->do_callback();
     _dragging_x = Fl::e_x + 30;
@@ -492,7 +555,7 @@ void Fl_Table::_auto_drag_cb() {
   if (ly > y() + h() - 20) {
     Fl::e_y = y() + h() - 20;
     if (vscrollbar->visible()) {
-      ((Fl_Slider*)vscrollbar)->value(vscrollbar->clamp(vscrollbar->value() + 30));
+      _vscroll_pos(_vscroll_pos() + 30);
     }
     vscrollbar->do_callback();
     _dragging_y = Fl::e_y - 30;
@@ -500,7 +563,7 @@ void Fl_Table::_auto_drag_cb() {
   else if (ly < (y() + col_header_height())) {
     Fl::e_y = y() + col_header_height() + 1;
     if (vscrollbar->visible()) {
-      ((Fl_Slider*)vscrollbar)->value(vscrollbar->clamp(vscrollbar->value() - 30));
+      _vscroll_pos(_vscroll_pos() - 30);
     }
     vscrollbar->do_callback();
     _dragging_y = Fl::e_y + 30;
@@ -563,38 +626,30 @@ void Fl_Table::recalc_dimensions() {
   TODO: Assumes ti[xywh] has already been recalculated.
 */
 void Fl_Table::table_scrolled() {
-  // Find top row
-  int y, row, voff = vscrollbar->value();
-  for ( row=y=0; row < _rows; row++ ) {
-    y += row_height(row);
-    if ( y > voff ) { y -= row_height(row); break; }
-  }
+  // Find top row: the first row whose bottom edge is below the scroll position
+  int row;
+  long long voff = _vscroll_pos();
+  row = _rowheights->find(voff);
+  if ( row > _rows ) row = _rows;
   _row_position = toprow = ( row >= _rows ) ? (row - 1) : row;
-  toprow_scrollpos = y;         // OPTIMIZATION: save for later use
-  // Find bottom row
-  voff = vscrollbar->value() + tih;
-  for ( ; row < _rows; row++ ) {
-    y += row_height(row);
-    if ( y >= voff ) { break; }
-  }
-  botrow = ( row >= _rows ) ? (row - 1) : row;
+  toprow_scrollpos = row_scroll_position(toprow);       // OPTIMIZATION: save for later use
+  // Find bottom row: the first row whose bottom edge reaches the window's bottom
+  voff += tih;
+  int brow = _rowheights->find(voff - 1);
+  if ( brow > row ) row = brow;
+  botrow = ( row >= _rows ) ? (_rows - 1) : row;
   // Left column
-  int x, col, hoff = hscrollbar->value();
-  for ( col=x=0; col < _cols; col++ ) {
-    x += col_width(col);
-    if ( x > hoff ) { x -= col_width(col); break; }
-  }
+  int col;
+  long long hoff = _hscroll_pos();
+  col = _colwidths->find(hoff);
+  if ( col > _cols ) col = _cols;
   _col_position = leftcol = ( col >= _cols ) ? (col - 1) : col;
-  leftcol_scrollpos = x;        // OPTIMIZATION: save for later use
+  leftcol_scrollpos = col_scroll_position(leftcol);     // OPTIMIZATION: save for later use
   // Right column
-  //    Work with data left over from leftcol calculation
-  //
-  hoff = hscrollbar->value() + tiw;
-  for ( ; col < _cols; col++ ) {
-    x += col_width(col);
-    if ( x >= hoff ) { break; }
-  }
-  rightcol = ( col >= _cols ) ? (col - 1) : col;
+  hoff += tiw;
+  int rcol = _colwidths->find(hoff - 1);
+  if ( rcol > col ) col = rcol;
+  rightcol = ( col >= _cols ) ? (_cols - 1) : col;
   // First tell children to scroll
   draw_cell(CONTEXT_RC_RESIZE, 0,0,0,0,0,0);
 }
@@ -604,33 +659,35 @@ void Fl_Table::table_scrolled() {
   Calls recall_dimensions(), and recalculates scrollbar sizes.
 */
 void Fl_Table::table_resized() {
-  table_h = (int)row_scroll_position(rows());
-  table_w = (int)col_scroll_position(cols());
+  long long top = _vscroll_pos(), left = _hscroll_pos();
+  table_h = row_scroll_position(rows());
+  table_w = col_scroll_position(cols());
   recalc_dimensions();
   // Recalc scrollbar sizes
-  //    Clamp scrollbar value() after a resize.
+  //    Clamp the scroll position after a resize.
   //    Resize scrollbars to enforce a constant trough width after a window resize.
+  //    Tables higher or wider than max_scrollbar_range pixels get a scaled scrollbar.
   //
   {
     // Vertical scrollbar
     float vscrolltab = ( table_h == 0 || tih > table_h ) ? 1 : (float)tih / table_h;
     float hscrolltab = ( table_w == 0 || tiw > table_w ) ? 1 : (float)tiw / table_w;
     int scrollsize = _scrollbar_size ? _scrollbar_size : Fl::scrollbar_size();
-    vscrollbar->bounds(0, table_h-tih);
+    vscrollbar->bounds(0, (double)std::min(table_h-tih, max_scrollbar_range));
     vscrollbar->precision(10);
     vscrollbar->slider_size(vscrolltab);
     vscrollbar->resize(wix+wiw-scrollsize, wiy,
                        scrollsize,
                        wih - ((hscrollbar->visible())?scrollsize:0));
-    vscrollbar->Fl_Valuator::value(vscrollbar->clamp(vscrollbar->value()));
+    _vscroll_pos(top);
     // Horizontal scrollbar
-    hscrollbar->bounds(0, table_w-tiw);
+    hscrollbar->bounds(0, (double)std::min(table_w-tiw, max_scrollbar_range));
     hscrollbar->precision(10);
     hscrollbar->slider_size(hscrolltab);
     hscrollbar->resize(wix, wiy+wih-scrollsize,
                        wiw - ((vscrollbar->visible())?scrollsize:0),
                        scrollsize);
-    hscrollbar->Fl_Valuator::value(hscrollbar->clamp(hscrollbar->value()));
+    _hscroll_pos(left);
   }
 
   // Tell FLTK child widgets were resized
@@ -660,7 +717,7 @@ void Fl_Table::rows(int val) {
   int oldrows = _rows;
   _rows = val;
 
-  int default_h = row_size() > 0 ? _rowheights->back() : 25;
+  int default_h = _rowheights->back(25);
   int now_size = row_size();
 
   if (now_size != val)
@@ -682,7 +739,7 @@ void Fl_Table::rows(int val) {
 void Fl_Table::cols(int val) {
   _cols = val;
 
-  int default_w = col_size() > 0 ? (*_colwidths)[col_size()-1] : 80;
+  int default_w = _colwidths->back(80);
   int now_size = col_size();
 
   if (now_size != val)
@@ -1353,13 +1410,14 @@ void Fl_Table::draw() {
 
       // Table width smaller than window? Fill remainder with rectangle
       if ( table_w < tiw ) {
-        fl_rectf(tix + table_w, tiy, tiw - table_w, tih, color());
+        int tw = (int)table_w;
+        fl_rectf(tix + tw, tiy, tiw - tw, tih, color());
         // Col header? fill that too
         if ( col_header() ) {
-          fl_rectf(tix + table_w,
+          fl_rectf(tix + tw,
                    wiy,
                    // get that corner just right..
-                   (tiw - table_w + Fl::box_dw(table->box()) -
+                   (tiw - tw + Fl::box_dw(table->box()) -
                     Fl::box_dx(table->box())),
                    col_header_height(),
                    color());
@@ -1367,15 +1425,16 @@ void Fl_Table::draw() {
       }
       // Table height smaller than window? Fill remainder with rectangle
       if ( table_h < tih ) {
-        fl_rectf(tix, tiy + table_h, tiw, tih - table_h, color());
+        int th = (int)table_h;
+        fl_rectf(tix, tiy + th, tiw, tih - th, color());
         if ( row_header() ) {
           // NOTE:
           //     Careful with that lower corner; don't use tih; when eg.
           //     table->box(FL_THIN_UP_FRAME) and hscrollbar hidden,
           //     leaves a row of dead pixels.
           //
-          fl_rectf(wix, tiy + table_h, row_header_width(),
-                   (wiy+wih) - (tiy+table_h) -
+          fl_rectf(wix, tiy + th, row_header_width(),
+                   (wiy+wih) - (tiy+th) -
                    ( hscrollbar->visible() ? scrollsize : 0),
                    color());
         }
@@ -1398,12 +1457,12 @@ void Fl_Table::draw() {
   Returns the current height of the specified row as a value in pixels.
 */
 int Fl_Table::row_height(int row) {
-  return((row < 0 || row >= row_size()) ? 0 : (*_rowheights)[row]);
+  return((row < 0 || row >= row_size()) ? 0 : _rowheights->get(row));
 }
 
 /**
   Returns the current width of the specified column in pixels.
 */
 int Fl_Table::col_width(int col) {
-  return((col < 0 || col >= col_size()) ? 0 : (*_colwidths)[col]);
+  return((col < 0 || col >= col_size()) ? 0 : _colwidths->get(col));
 }
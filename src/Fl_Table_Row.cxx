@@ -26,7 +26,9 @@
 #include <FL/Fl_Table_Row.H>
 #include <FL/Fl.H>
 #include <FL/fl_draw.H>
+#include "Fl_Table_Row_Selection.H"
 #include <stdlib.h>
+#include <limits.h>
 
 // for debugging...
 // #define DEBUG 1
@@ -40,6 +42,29 @@
 #endif
 
 
+/**
+  The constructor for the Fl_Table_Row.
+  This creates an empty table with no rows or columns,
+  with headers and row/column resize behavior disabled.
+*/
+Fl_Table_Row::Fl_Table_Row(int X, int Y, int W, int H, const char *l) : Fl_Table(X,Y,W,H,l) {
+  _rowselect       = new Fl_Table_Row_Selection;
+  _dragging_select = 0;
+  _last_row        = -1;
+  _last_y          = -1;
+  _last_push_x     = -1;
+  _last_push_y     = -1;
+  _selectmode      = SELECT_MULTI;
+}
+
+/**
+  The destructor for the Fl_Table_Row.
+  Destroys the table and its associated widgets.
+*/
+Fl_Table_Row::~Fl_Table_Row() {
+  delete _rowselect;
+}
+
 /**
   Checks to see if 'row' is selected.
 
@@ -57,7 +82,7 @@
 */
 int Fl_Table_Row::row_selected(int row) {
   if (row < 0 || row >= rows()) return 0;
-  return _rowselect[row];
+  return _rowselect->selected(row) ? 1 : 0;
 }
 
 // Change row selection type
@@ -65,20 +90,14 @@ void Fl_Table_Row::type(TableRowSelectMode val) {
   _selectmode = val;
   switch ( _selectmode ) {
     case SELECT_NONE: {
-      for (auto &sel : _rowselect) {
-        sel = 0;
-      }
+      _rowselect->clear();
       redraw();
       break;
     }
     case SELECT_SINGLE: {
-      int count = 0;
-      for (auto &sel : _rowselect) {
-        if (sel) {
-          if (++count > 1) {  // only one allowed
-            sel = 0;
-          }
-        }
+      int first = _rowselect->first();
+      if ( first >= 0 ) {     // only one allowed
+        _rowselect->select(first + 1, INT_MAX, false);
       }
       redraw();
       break;
@@ -112,30 +131,28 @@ int Fl_Table_Row::select_row(int row, int flag) {
       return(-1);
 
     case SELECT_SINGLE: {
-      int oldval;
-      for ( int t=0; t<rows(); t++ ) {
-        if ( t == row ) {
-          oldval = _rowselect[row];
-          if ( flag == 2 ) { _rowselect[row] ^= 1; }
-          else             { _rowselect[row] = flag; }
-          if ( oldval != _rowselect[row] ) {
-            redraw_range(row, row, leftcol, rightcol);
-            ret = 1;
-          }
-        }
-        else if ( _rowselect[t] ) {
-          _rowselect[t] = 0;
-          redraw_range(t, t, leftcol, rightcol);
-        }
+      // Deselect the other row, if any
+      int t = _rowselect->first();
+      if ( t == row ) t = -1;
+      if ( t >= 0 ) {
+        _rowselect->clear();
+        redraw_range(t, t, leftcol, rightcol);
+      }
+      int oldval = row_selected(row);
+      int newval = ( flag == 2 ) ? !oldval : ( flag != 0 );
+      if ( oldval != newval ) {
+        _rowselect->select(row, row + 1, newval != 0);
+        redraw_range(row, row, leftcol, rightcol);
+        ret = 1;
       }
       break;
     }
 
     case SELECT_MULTI: {
-      int oldval = _rowselect[row];
-      if ( flag == 2 ) { _rowselect[row] ^= 1; }
-      else             { _rowselect[row] = flag; }
-      if ( _rowselect[row] != oldval ) {                // select state changed?
+      int oldval = row_selected(row);
+      int newval = ( flag == 2 ) ? !oldval : ( flag != 0 );
+      if ( newval != oldval ) {                         // select state changed?
+        _rowselect->select(row, row + 1, newval != 0);
         if ( row >= toprow && row <= botrow ) {         // row visible?
           // Extend partial redraw range
           redraw_range(row, row, leftcol, rightcol);
@@ -147,6 +164,67 @@ int Fl_Table_Row::select_row(int row, int flag) {
   return(ret);
 }
 
+/**
+  Changes the selection state for the rows \p from to \p to, depending
+  on the value of \p flag, in the same way as select_row().
+
+  In SELECT_MULTI mode this takes O(log n) time for n selected ranges,
+  regardless of the number of rows. In SELECT_SINGLE mode only the last
+  row of the range is changed. Rows outside the table are ignored.
+
+  \param[in]  from  first row to be changed
+  \param[in]  to    last row to be changed, can be less than \p from
+  \param[in]  flag  0: deselect, 1: select (default), 2: toggle
+  \return     result of modification
+  \retval   0: selection state did not change
+  \retval   1: selection state changed
+  \retval  -1: no row in range or incorrect selection mode
+  \see select_row(), next_selected_range()
+  \since 1.5.0
+*/
+int Fl_Table_Row::select_rows(int from, int to, int flag) {
+  if ( from > to ) { int t = from; from = to; to = t; }
+  if ( from < 0 ) { from = 0; }
+  if ( to >= rows() ) { to = rows() - 1; }
+  if ( from > to || _selectmode == SELECT_NONE ) { return(-1); }
+  if ( _selectmode == SELECT_SINGLE ) { return(select_row(to, flag)); }
+  int ret = 1;
+  if ( flag == 2 ) { _rowselect->toggle(from, to + 1); }
+  else             { ret = _rowselect->select(from, to + 1, flag != 0) ? 1 : 0; }
+  if ( ret && to >= toprow && from <= botrow ) {        // rows visible?
+    // Extend partial redraw range
+    redraw_range(from < toprow ? toprow : from, to > botrow ? botrow : to,
+                 leftcol, rightcol);
+  }
+  return(ret);
+}
+
+/**
+  Finds the next range of selected rows.
+
+  Use this to enumerate all selected rows in time proportional to the
+  number of selected ranges rather than the number of rows:
+  \code
+    int first, last;
+    for ( int row = 0; table->next_selected_range(row, first, last); row = last + 1 ) {
+      // rows first to last are selected
+    }
+  \endcode
+
+  \param[in]  row    row where the search starts
+  \param[out] first  first selected row of the range, at least \p row
+  \param[out] last   last selected row of the range
+  \return     1 if a range was found, 0 if no row at or after \p row is selected
+  \since 1.5.0
+*/
+int Fl_Table_Row::next_selected_range(int row, int &first, int &last) const {
+  int end;
+  if ( row < 0 ) row = 0;
+  if ( !_rowselect->next_range(row, first, end) ) { return(0); }
+  last = end - 1;
+  return(1);
+}
+
 // Select all rows to a known state
 void Fl_Table_Row::select_all_rows(int flag) {
   switch ( _selectmode ) {
@@ -160,15 +238,13 @@ void Fl_Table_Row::select_all_rows(int flag) {
     case SELECT_MULTI: {
       char changed = 0;
       if ( flag == 2 ) {
-        for (auto &sel : _rowselect) {
-          sel ^= 1;
-        }
-        changed = 1;
+        _rowselect->toggle(0, rows());
+        changed = ( rows() > 0 );
+      } else if ( flag == 0 ) {
+        changed = !_rowselect->empty();
+        _rowselect->clear();
       } else {
-        for (auto &sel : _rowselect) {
-          changed |= (sel != flag) ? 1 : 0;
-          sel = flag;
-        }
+        changed = _rowselect->select(0, rows(), true);
       }
       if ( changed ) {
         redraw();
@@ -179,10 +255,9 @@ void Fl_Table_Row::select_all_rows(int flag) {
 
 // Set number of rows
 void Fl_Table_Row::rows(int val) {
-  // Note: order of operations below matters, see PR #1187
-  if (val > (int)_rowselect.size()) { _rowselect.resize(val, 0); }  // enlarge
+  // Note: deselect removed rows first, see PR #1187
+  _rowselect->select(val, INT_MAX, false);
   Fl_Table::rows(val);
-  if (val < (int)_rowselect.size()) { _rowselect.resize(val); }     // shrink
 }
 
 // Handle events
@@ -234,14 +309,7 @@ int Fl_Table_Row::handle(int event) {
             case FL_SHIFT: {
               select_row(R, 1);
               if ( _last_row > -1 ) {
-                int srow = R, erow = _last_row;
-                if ( srow > erow ) {
-                  srow = _last_row;
-                  erow = R;
-                }
-                for ( int row = srow; row <= erow; row++ ) {
-                  select_row(row, 1);
-                }
+                select_rows(_last_row, R, 1);
               }
               break;
             }
@@ -300,14 +368,7 @@ int Fl_Table_Row::handle(int event) {
             default:
               select_row(R, 1);
               if ( _last_row > -1 ) {
-                int srow = R, erow = _last_row;
-                if ( srow > erow ) {
-                  srow = _last_row;
-                  erow = R;
-                }
-                for ( int row = srow; row <= erow; row++ ) {
-                  select_row(row, 1);
-                }
+                select_rows(_last_row, R, 1);
               }
               break;
           }
@@ -325,7 +386,7 @@ int Fl_Table_Row::handle(int event) {
         // Clicked off edges of data table?
         //    A way for user to clear the current selection.
         //
-        int databot = tiy + table_h,
+        long long databot = tiy + table_h,
         dataright = tix + table_w;
         if (
             ( _last_push_x > dataright && _event_x > dataright ) ||
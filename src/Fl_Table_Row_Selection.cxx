@@ -0,0 +1,123 @@
+//
+// Row selection storage for Fl_Table_Row for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Table_Row_Selection.H"
+
+#include <vector>
+
+
+bool Fl_Table_Row_Selection::selected(int row) const {
+  std::map<int, int>::const_iterator it = ranges_.upper_bound(row);
+  if (it == ranges_.begin()) return false;
+  --it;
+  return row < it->second;
+}
+
+
+bool Fl_Table_Row_Selection::select(int from, int to, bool on) {
+  if (from >= to) return false;
+  std::map<int, int>::iterator it = ranges_.upper_bound(from);
+  if (on) {
+    // merge with all ranges that overlap or touch from..to-1
+    if (it != ranges_.begin()) {
+      std::map<int, int>::iterator prev = it;
+      --prev;
+      if (prev->second >= to) return false;     // already selected
+      if (prev->second >= from) {
+        from = prev->first;
+        if (prev->second > to) to = prev->second;
+        it = prev;
+      }
+    }
+    while (it != ranges_.end() && it->first <= to) {
+      if (it->second > to) to = it->second;
+      ranges_.erase(it++);
+    }
+    ranges_[from] = to;
+    return true;
+  }
+  bool changed = false;
+  // cut the range that starts before from..to-1
+  if (it != ranges_.begin()) {
+    std::map<int, int>::iterator prev = it;
+    --prev;
+    if (prev->second > from) {
+      int end = prev->second;
+      if (prev->first == from) ranges_.erase(prev);
+      else prev->second = from;
+      if (end > to) {
+        ranges_[to] = end;
+        return true;
+      }
+      changed = true;
+    }
+  }
+  // remove or cut the ranges that start inside from..to-1
+  while (it != ranges_.end() && it->first < to) {
+    int end = it->second;
+    ranges_.erase(it++);
+    changed = true;
+    if (end > to) {
+      ranges_[to] = end;
+      break;
+    }
+  }
+  return changed;
+}
+
+
+void Fl_Table_Row_Selection::toggle(int from, int to) {
+  if (from >= to) return;
+  // collect the unselected gaps, then swap them with the selected ranges
+  std::vector<int> gaps;
+  int row = from;
+  std::map<int, int>::const_iterator it = ranges_.upper_bound(from);
+  if (it != ranges_.begin()) {
+    std::map<int, int>::const_iterator prev = it;
+    --prev;
+    if (prev->second > row) row = prev->second;
+  }
+  for (; row < to; ++it) {
+    int end = (it == ranges_.end() || it->first > to) ? to : it->first;
+    if (row < end) {
+      gaps.push_back(row);
+      gaps.push_back(end);
+    }
+    if (it == ranges_.end()) break;
+    row = it->second;
+  }
+  select(from, to, false);
+  for (int i = 0; i < (int)gaps.size(); i += 2)
+    select(gaps[i], gaps[i + 1], true);
+}
+
+
+bool Fl_Table_Row_Selection::next_range(int row, int &first, int &end) const {
+  std::map<int, int>::const_iterator it = ranges_.upper_bound(row);
+  if (it != ranges_.begin()) {
+    std::map<int, int>::const_iterator prev = it;
+    --prev;
+    if (prev->second > row) {
+      first = row;
+      end = prev->second;
+      return true;
+    }
+  }
+  if (it == ranges_.end()) return false;
+  first = it->first;
+  end = it->second;
+  return true;
+}
@@ -0,0 +1,270 @@
+//
+// Row height and column width index for Fl_Table for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Table_Size_Index.H"
+
+
+Fl_Table_Size_Index::Fl_Table_Size_Index()
+  : root_(0),
+    n_(0),
+    def_(0),
+    seed_(0x2545F491)
+{
+}
+
+
+Fl_Table_Size_Index::~Fl_Table_Size_Index() {
+  free_tree_(root_);
+}
+
+
+/*
+ Xorshift generator for node priorities.
+ */
+unsigned Fl_Table_Size_Index::random_() {
+  seed_ ^= seed_ << 13;
+  seed_ ^= seed_ >> 17;
+  seed_ ^= seed_ << 5;
+  return seed_;
+}
+
+
+Fl_Table_Size_Index::Node *Fl_Table_Size_Index::new_node_(int start, int len, int size) {
+  Node *n = new Node;
+  n->left = n->right = 0;
+  n->start = start;
+  n->len = len;
+  n->size = size;
+  n->prio = random_();
+  update_(n);
+  return n;
+}
+
+
+void Fl_Table_Size_Index::free_tree_(Node *n) {
+  while (n) {
+    free_tree_(n->left);
+    Node *r = n->right;
+    delete n;
+    n = r;
+  }
+}
+
+
+/*
+ Join two trees. All runs of a come before all runs of b.
+ */
+Fl_Table_Size_Index::Node *Fl_Table_Size_Index::merge_(Node *a, Node *b) {
+  if (!a) return b;
+  if (!b) return a;
+  if (a->prio >= b->prio) {
+    a->right = merge_(a->right, b);
+    update_(a);
+    return a;
+  }
+  b->left = merge_(a, b->left);
+  update_(b);
+  return b;
+}
+
+
+/*
+ Split a tree into the runs before item i (l) and the rest (r). A run that
+ straddles item i is cut in two.
+ */
+void Fl_Table_Size_Index::split_(Node *t, int i, Node *&l, Node *&r) {
+  if (!t) {
+    l = r = 0;
+    return;
+  }
+  if (i <= t->start) {
+    split_(t->left, i, l, t->left);
+    update_(t);
+    r = t;
+  } else if (i >= t->start + t->len) {
+    split_(t->right, i, t->right, r);
+    update_(t);
+    l = t;
+  } else {
+    Node *n = new Node;
+    n->left = 0;
+    n->right = t->right;
+    n->start = i;
+    n->len = t->start + t->len - i;
+    n->size = t->size;
+    n->prio = t->prio;
+    t->len = i - t->start;
+    t->right = 0;
+    update_(n);
+    update_(t);
+    l = t;
+    r = n;
+  }
+}
+
+
+/*
+ Remove the first run from a tree and return it, or NULL if t is empty.
+ */
+Fl_Table_Size_Index::Node *Fl_Table_Size_Index::pop_first_(Node *&t) {
+  if (!t) return 0;
+  if (!t->left) {
+    Node *n = t;
+    t = t->right;
+    n->right = 0;
+    update_(n);
+    return n;
+  }
+  Node *n = pop_first_(t->left);
+  update_(t);
+  return n;
+}
+
+
+/*
+ Remove the last run from a tree and return it, or NULL if t is empty.
+ */
+Fl_Table_Size_Index::Node *Fl_Table_Size_Index::pop_last_(Node *&t) {
+  if (!t) return 0;
+  if (!t->right) {
+    Node *n = t;
+    t = t->left;
+    n->left = 0;
+    update_(n);
+    return n;
+  }
+  Node *n = pop_last_(t->right);
+  update_(t);
+  return n;
+}
+
+
+void Fl_Table_Size_Index::resize(int n, int value) {
+  if (n < 0) n = 0;
+  if (n < n_) {
+    Node *r;
+    split_(root_, n, root_, r);
+    free_tree_(r);
+  } else if (n > n_) {
+    if (!root_ && !n_) def_ = value;
+    if (value != def_) {
+      // append a run, or extend the last one
+      Node *last = pop_last_(root_);
+      if (last && last->start + last->len == n_ && last->size == value) {
+        last->len += n - n_;
+        update_(last);
+        root_ = merge_(root_, last);
+      } else {
+        root_ = merge_(merge_(root_, last), new_node_(n_, n - n_, value));
+      }
+    }
+  }
+  n_ = n;
+}
+
+
+int Fl_Table_Size_Index::get(int i) const {
+  const Node *t = root_;
+  while (t) {
+    if (i < t->start) t = t->left;
+    else if (i >= t->start + t->len) t = t->right;
+    else return t->size;
+  }
+  return def_;
+}
+
+
+void Fl_Table_Size_Index::set(int i, int value) {
+  if (i < 0 || i >= n_ || get(i) == value) return;
+  Node *l, *m, *r;
+  split_(root_, i, l, m);
+  split_(m, i + 1, m, r);
+  free_tree_(m);
+  if (value == def_) {
+    root_ = merge_(l, r);
+    return;
+  }
+  // Extend the neighboring runs if they have the same size, so that
+  // setting many rows one by one does not create a run for every row.
+  Node *n = pop_last_(l);
+  if (n && n->start + n->len == i && n->size == value) {
+    n->len++;
+  } else {
+    l = merge_(l, n);
+    n = new_node_(i, 1, value);
+  }
+  Node *next = pop_first_(r);
+  if (next && next->start == i + 1 && next->size == value) {
+    n->len += next->len;
+    delete next;
+  } else {
+    r = merge_(next, r);
+  }
+  update_(n);
+  root_ = merge_(merge_(l, n), r);
+}
+
+
+void Fl_Table_Size_Index::fill(int value) {
+  free_tree_(root_);
+  root_ = 0;
+  def_ = value;
+}
+
+
+long long Fl_Table_Size_Index::position(int i) const {
+  if (i <= 0) return 0;
+  if (i >= n_) return total();
+  // sum the differences to the default size of all runs before item i
+  const Node *t = root_;
+  long long delta = 0;
+  while (t) {
+    if (i <= t->start) {
+      t = t->left;
+    } else if (i >= t->start + t->len) {
+      delta += delta_(t->left) + (long long)t->len * (t->size - def_);
+      t = t->right;
+    } else {
+      delta += delta_(t->left) + (long long)(i - t->start) * (t->size - def_);
+      break;
+    }
+  }
+  return (long long)i * def_ + delta;
+}
+
+
+int Fl_Table_Size_Index::find(long long pos) const {
+  if (pos < 0) return 0;
+  const Node *t = root_;
+  long long delta = 0;  // size difference to the default of all runs left of t
+  int end = n_;         // items from here on are after pos
+  while (t) {
+    long long start = (long long)t->start * def_ + delta + delta_(t->left);
+    if (pos < start) {
+      end = t->start;
+      t = t->left;
+    } else if (pos < start + (long long)t->len * t->size) {
+      return t->start + (int)((pos - start) / t->size);
+    } else {
+      delta += delta_(t->left) + (long long)t->len * (t->size - def_);
+      t = t->right;
+    }
+  }
+  // pos is in a gap between runs, or after the last run
+  if (def_ <= 0) return end;
+  long long i = (pos - delta) / def_;
+  return i < end ? (int)i : end;
+}
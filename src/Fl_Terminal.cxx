@@ -36,6 +36,7 @@
 #include <FL/fl_utf8.h> // fl_utf8len1
 #include <FL/fl_draw.H>
 #include <FL/fl_string_functions.h>
+#include "Fl_Terminal_Palette.H"
 
 /////////////////////////////////
 ////// Static Functions /////////
@@ -466,10 +467,21 @@ Fl_Terminal::CharStyle::CharStyle(bool fontsize_defer) {
   bgcolor_          = defaultbgcolor_;
   fontface_         = FL_COURIER;
   fontsize_         = 14;
+  colors_           = 0;
   if (!fontsize_defer) update();       // normal behavior
   else                 update_fake();  // use fake values instead
 }
 
+// Return the palette index of the current fg/bg colors.
+//    The index is cached while the palette still has these colors at that index.
+//
+unsigned Fl_Terminal::CharStyle::colors(void) const {
+  Fl_Terminal_Palette *palette = Fl_Terminal_Palette::instance();
+  if (!palette->is(colors_, fgcolor_, bgcolor_))
+    colors_ = palette->index(fgcolor_, bgcolor_);
+  return colors_;
+}
+
 // Update fontheight/descent cache whenever font changes
 void Fl_Terminal::CharStyle::update(void) {
   // cache these values
@@ -535,24 +547,24 @@ void Fl_Terminal::Cursor::scroll(int nrows) {
 /////////////////////////////////////
 
 // Ctor
+//    Colors are palette index 0: fg 0xffffff00,
+//    bg 0xffffffff (special color: doesn't draw, 'shows thru' to box())
+//
 Fl_Terminal::Utf8Char::Utf8Char(void) {
   text_[0]   = ' ';
-  len_       = 1;
   attrib_    = 0;
   charflags_ = 0;
-  fgcolor_   = 0xffffff00;
-  bgcolor_   = 0xffffffff;   // special color: doesn't draw, 'shows thru' to box()
+  colors_(0);
 }
 
 // copy ctor
 Fl_Terminal::Utf8Char::Utf8Char(const Utf8Char& src) {
   // local instance not initialized yet; init first, then copy text
   text_[0]   = ' ';
-  len_       = 1;
   attrib_    = src.attrib_;
   charflags_ = src.charflags_;
-  fgcolor_   = src.fgcolor_;
-  bgcolor_   = src.bgcolor_;
+  colors_lo_ = src.colors_lo_;
+  colors_hi_ = src.colors_hi_;
   text_utf8_(src.text_utf8(), src.length());    // copy the src text
 }
 
@@ -562,25 +574,24 @@ Fl_Terminal::Utf8Char& Fl_Terminal::Utf8Char::operator=(const Utf8Char& src) {
   text_utf8_(src.text_utf8(), src.length());    // local copy src text
   attrib_    = src.attrib_;
   charflags_ = src.charflags_;
-  fgcolor_   = src.fgcolor_;
-  bgcolor_   = src.bgcolor_;
+  colors_lo_ = src.colors_lo_;
+  colors_hi_ = src.colors_hi_;
   return *this;
 }
 
 // dtor
 Fl_Terminal::Utf8Char::~Utf8Char(void) {
-  len_ = 0;
 }
 
 // Set 'text_' to valid UTF-8 string 'text'.
 //
 // text_ must not be NULL, and len must be in range: 1 <= len <= max_utf8().
+// len must be the length given by the first byte, see length().
 // NOTE: Caller must handle such checks, and use handle_unknown_char()
 // for invalid chars.
 //
 void Fl_Terminal::Utf8Char::text_utf8_(const char *text, int len) {
   memcpy(text_, text, len);
-  len_ = len;                                    // update new length
 }
 
 // Set UTF-8 string for this char.
@@ -592,12 +603,11 @@ void Fl_Terminal::Utf8Char::text_utf8_(const char *text, int len) {
 void Fl_Terminal::Utf8Char::text_utf8(const char *text,
                                       int len,
                                       const CharStyle& style) {
-  text_utf8_(text, len);                       // updates text_, len_
+  text_utf8_(text, len);                       // updates text_
   //issue 837 // fl_font(style.fontface(), style.fontsize()); // need font to calc UTF-8 width
   attrib_    = style.attrib();
   charflags_ = style.colorbits_only(charflags_);
-  fgcolor_   = style.fgcolor();
-  bgcolor_   = style.bgcolor();
+  colors_(style.colors());
 }
 
 // Set char to single printable ASCII character 'c'
@@ -620,12 +630,12 @@ void Fl_Terminal::Utf8Char::fl_font_set(const CharStyle& style) const {
 
 // Return the foreground color as an fltk color
 Fl_Color Fl_Terminal::Utf8Char::fgcolor(void) const {
-  return fgcolor_;
+  return Fl_Terminal_Palette::instance()->fg(colors());
 }
 
 // Return the background color as an fltk color
 Fl_Color Fl_Terminal::Utf8Char::bgcolor(void) const {
-  return bgcolor_;
+  return Fl_Terminal_Palette::instance()->bg(colors());
 }
 
 // Return the width of this character in floating point pixels
@@ -634,7 +644,7 @@ Fl_Color Fl_Terminal::Utf8Char::bgcolor(void) const {
 //             has already been set to current font!
 //
 double Fl_Terminal::Utf8Char::pwidth(void) const {
-  return fl_width(text_, len_);
+  return fl_width(text_, length());
 }
 
 // Return the width of this character in integer pixels
@@ -643,7 +653,7 @@ double Fl_Terminal::Utf8Char::pwidth(void) const {
 //             has already been set to current font!
 //
 int Fl_Terminal::Utf8Char::pwidth_int(void) const {
-  return int(fl_width(text_, len_) + 0.5);
+  return int(fl_width(text_, length()) + 0.5);
 }
 
 // Return color \p col, possibly influenced by BOLD or DIM attributes \p attr.
@@ -666,19 +676,21 @@ Fl_Color Fl_Terminal::Utf8Char::attr_color_(Fl_Color col, const Fl_Widget *grp)
 //    influenced by the attribute bits /if/ \p col matches the \p grp widget's own color().
 //
 Fl_Color Fl_Terminal::Utf8Char::attr_fg_color(const Fl_Widget *grp) const {
-  if (grp && (fgcolor_ == 0xffffffff))           // see thru color?
+  Fl_Color fg = fgcolor();
+  if (grp && (fg == 0xffffffff))                 // see thru color?
     { return grp->color(); }                     // return grp's color()
   return (charflags_ & Fl_Terminal::FG_XTERM)    // fg is an xterm color?
-           ? attr_color_(fgcolor(), grp)         // ..use attributes
-           : fgcolor();                          // ..ignore attributes.
+           ? attr_color_(fg, grp)                // ..use attributes
+           : fg;                                 // ..ignore attributes.
 }
 
 Fl_Color Fl_Terminal::Utf8Char::attr_bg_color(const Fl_Widget *grp) const {
-  if (grp && (bgcolor_ == 0xffffffff))           // see thru color?
+  Fl_Color bg = bgcolor();
+  if (grp && (bg == 0xffffffff))                 // see thru color?
     { return grp->color(); }                     // return grp's color()
   return (charflags_ & Fl_Terminal::BG_XTERM)    // bg is an xterm color?
-           ? attr_color_(bgcolor(), grp)         // ..use attributes
-           : bgcolor();                          // ..ignore attributes.
+           ? attr_color_(bg, grp)                // ..use attributes
+           : bg;                                 // ..ignore attributes.
 }
 
 
@@ -3142,6 +3154,32 @@ void Fl_Terminal::utf8_cache_flush(void) {
   pub_.clear();
 }
 
+// Print the run of printable ASCII chars at the start of 'text' (at most 'len' bytes)
+// at the cursor position, and advance the cursor. The run ends at the first byte that
+// is not printable ASCII, or at the end of the cursor's row; the cursor then wraps
+// just like print_char() would. Returns the number of chars printed, at least 1.
+//
+int Fl_Terminal::print_ascii_run(const char *text, int len) {
+  const bool do_scroll = true;
+  int col = cursor_col();
+  int n = disp_cols() - col;                   // room left in cursor's row
+  if (n > len) n = len;
+  if (n <= 0) { print_char(*text); return 1; } // cursor off screen? let print_char() handle it
+  int i = 0;
+  while (i < n && is_printable(text[i])) i++;  // find end of run
+  if (i == 0) { print_char(*text); return 1; }
+  Utf8Char *u8c = u8c_disp_row(cursor_row()) + col;
+  for (int t = 0; t < i; t++)
+    u8c[t].text_utf8(text + t, 1, *current_style_);
+  if (col + i < disp_cols()) {                 // run ends inside the row?
+    cursor_.col(col + i);
+  } else {                                     // run fills the row: wrap
+    cursor_.col(disp_cols() - 1);
+    cursor_right(1, do_scroll);
+  }
+  return i;
+}
+
 /**
   Append NULL terminated UTF-8 string to terminal.
 
@@ -3178,6 +3216,13 @@ void Fl_Terminal::append_utf8(const char *buf, int len/*=-1*/) {
   int clen;                                 // char length
   const char *p = buf;                      // ptr to walk buffer
   while (len>0) {
+    if (is_printable(*p) && !escseq.parse_in_progress()) {
+      clen = print_ascii_run(p, len);       // plain ASCII? print whole run at once
+      p   += clen;
+      len -= clen;
+      mod |= 1;
+      continue;
+    }
     clen = fl_utf8len(*p);                  // how many bytes long is this char?
     if (clen == -1) {                       // not expecting bad UTF-8 here
       mod |= handle_unknown_char();
@@ -3380,6 +3425,18 @@ void Fl_Terminal::redraw_timer_cb(void *udata) {
   tty->redraw_timer_cb2();
 }
 
+// The color palette frees the pairs not marked as used by any terminal
+void Fl_Terminal::palette_collect_cb2(void) {
+  Fl_Terminal_Palette *palette = Fl_Terminal_Palette::instance();
+  const Utf8Char *u8c = ring_.ring_chars();
+  for (int i=0; i<ring_rows()*ring_cols(); i++) palette->mark(u8c[i].colors());
+}
+
+void Fl_Terminal::palette_collect_cb(void *udata) {
+  Fl_Terminal *tty = (Fl_Terminal*)udata;
+  tty->palette_collect_cb2();
+}
+
 /**
   The constructor for Fl_Terminal.
 
@@ -3430,6 +3487,7 @@ void Fl_Terminal::init_(int X,int Y,int W,int H,const char*L,int rows,int cols,i
   (void)X; (void)Y; (void)W; (void)H; (void)L;
   fontsize_defer_ = fontsize_defer;     // defer font calls until draw() (issue 837)
   current_style_  = new CharStyle(fontsize_defer);
+  Fl_Terminal_Palette::add_user(palette_collect_cb, (void*)this);
   oflags_         = LF_TO_CRLF;         // default: "\n" handled as "\r\n"
   // scrollbar_size must be set before scrn_
   scrollbar_size_ = 0;                  // 0 uses Fl::scrollbar_size()
@@ -3438,6 +3496,10 @@ void Fl_Terminal::init_(int X,int Y,int W,int H,const char*L,int rows,int cols,i
   // Tabs
   tabstops_       = 0;
   tabstops_size_  = 0;
+  // Scratch buffers for draw_row()
+  row_widths_     = 0;
+  row_text_       = 0;
+  row_size_       = 0;
   // Init ringbuffer. Also creates default tabstops
   if (rows == -1 || cols == -1) {
     int newrows = h_to_row(scrn_.h());  // rows based on height
@@ -3493,11 +3555,14 @@ Fl_Terminal::~Fl_Terminal(void) {
   // Note: RingBuffer class handles destroying itself
   if (tabstops_)
     { free(tabstops_); tabstops_ = 0; }
+  free(row_widths_);
+  free(row_text_);
   if (autoscroll_dir_)
     { Fl::remove_timeout(autoscroll_timer_cb, this); autoscroll_dir_ = 0; }
   if (redraw_timer_)
     { Fl::remove_timeout(redraw_timer_cb, this); redraw_timer_ = false; }
   delete current_style_;
+  Fl_Terminal_Palette::remove_user((void*)this);
 }
 
 /**
@@ -3581,12 +3646,71 @@ void  Fl_Terminal::hscrollbar_style(ScrollbarStyle val) {
 ////// SCREEN DRAWING //////
 ////////////////////////////
 
+// Measure the widths of the \p cols chars starting at \p u8c in integer pixels,
+// each in its own font. The width of an ASCII char is measured only once per font,
+// so a whole row usually needs only a few fl_width() calls.
+//
+//    WARNING: Leaves fl_font() set to the font of some char in the row!
+//
+void Fl_Terminal::measure_row(const Utf8Char *u8c, int cols, int *pwidths) const {
+  short ascii[4][128];                  // ASCII widths for BOLD/ITALIC fonts, -1 if unknown
+  memset(ascii, 0xff, sizeof(ascii));
+  int lastfont = -1;
+  for (int col=0; col<cols; col++,u8c++) {
+    int font = ((u8c->attrib() & Fl_Terminal::BOLD)   ? 1 : 0) |
+               ((u8c->attrib() & Fl_Terminal::ITALIC) ? 2 : 0);
+    uchar c = (uchar)u8c->text_utf8()[0];
+    bool is_ascii = (u8c->length() == 1 && c < 0x80);
+    if (is_ascii && ascii[font][c] >= 0) { pwidths[col] = ascii[font][c]; continue; }
+    if (font != lastfont) {
+      u8c->fl_font_set(*current_style_);                  // pwidth_int() needs fl_font set
+      lastfont = font;
+    }
+    pwidths[col] = u8c->pwidth_int();
+    if (is_ascii) ascii[font][c] = (short)pwidths[col];
+  }
+}
+
+// Make the scratch buffers used by draw_row() large enough for \p cols chars.
+//
+void Fl_Terminal::row_scratch(int cols) const {
+  if (cols <= row_size_) return;
+  free(row_widths_);
+  free(row_text_);
+  row_widths_ = (int*)malloc(cols * sizeof(int));
+  row_text_   = (char*)malloc(cols);
+  row_size_   = cols;
+}
+
+// Return the color used to draw the text of char \p u8c at global row/col \p grow / \p gcol,
+// taking the mouse selection and the INVERSE attribute into account.
+//
+Fl_Color Fl_Terminal::draw_fg_color(int grow, int gcol, const Utf8Char *u8c) const {
+  return is_inside_selection(grow, gcol)                // text in mouse selection?
+    ? select_.selectionfgcolor()                        // ..use selection FG color
+    : (u8c->attrib() & Fl_Terminal::INVERSE)            // Inverse attrib?
+      ? u8c->attr_bg_color(this)                        // ..use char's bg color for fg
+      : u8c->attr_fg_color(this);                       // ..use char's fg color for fg
+}
+
+// Return the background color of char \p u8c at global row/col \p grow / \p gcol,
+// taking the mouse selection and the INVERSE attribute into account.
+//
+Fl_Color Fl_Terminal::draw_bg_color(int grow, int gcol, const Utf8Char *u8c) const {
+  return is_inside_selection(grow, gcol)                // text in mouse select?
+    ? select_.selectionbgcolor()                        // ..use select bg color
+    : (u8c->attrib() & Fl_Terminal::INVERSE)            // Inverse mode?
+      ? u8c->attr_fg_color(this)                        // ..use fg color for bg
+      : u8c->attr_bg_color(this);                       // ..use bg color for bg
+}
+
 /**
   Draw the background for the specified ring_chars[] global row \p grow
   starting at FLTK coords \p X and \p Y.
 
   Note we may be called to draw display, or even history if we're scrolled back.
   If there's any change in bg color, we draw the filled rects here.
+  Adjacent chars with the same bg color are filled with a single rect.
 
   If the bg color for a character is the special "see through" color 0xffffffff,
   no pixels are drawn.
@@ -3595,32 +3719,38 @@ void  Fl_Terminal::hscrollbar_style(ScrollbarStyle val) {
  \param[in] X, Y top left corner of the row in FLTK coordinates
 */
 void Fl_Terminal::draw_row_bg(int grow, int X, int Y) const {
+  int start_col = hscrollbar->visible() ? hscrollbar->value() : 0;
+  int end_col   = disp_cols();
+  if (start_col >= end_col) return;
+  row_scratch(end_col - start_col);
+  measure_row(u8c_ring_row(grow) + start_col, end_col - start_col, row_widths_);
+  draw_row_bg(grow, X, Y, row_widths_);
+}
+
+// Same as draw_row_bg(int,int,int), with the pixel widths \p pwidths of the
+// visible chars of the row already measured by measure_row().
+//
+void Fl_Terminal::draw_row_bg(int grow, int X, int Y, const int *pwidths) const {
   int bg_h = current_style_->fontheight();
   int bg_y = Y;
-  Fl_Color bg_col;
-  int pwidth    = 9;
   int start_col = hscrollbar->visible() ? hscrollbar->value() : 0;
   int end_col   = disp_cols();
+  if (start_col >= end_col) return;
   const Utf8Char *u8c = u8c_ring_row(grow) + start_col;   // start of spec'd row
-  uchar lastattr      = u8c->attrib();
-  for (int gcol=start_col; gcol<end_col; gcol++,u8c++) {  // walk columns
-    // Attribute changed since last char?
-    if (gcol==0 || u8c->attrib() != lastattr) {
-      u8c->fl_font_set(*current_style_);                  // pwidth_int() needs fl_font set
-      lastattr = u8c->attrib();
-    }
-    pwidth = u8c->pwidth_int();
-    bg_col = is_inside_selection(grow, gcol)              // text in mouse select?
-               ? select_.selectionbgcolor()               // ..use select bg color
-               : (u8c->attrib() & Fl_Terminal::INVERSE)   // Inverse mode?
-                 ? u8c->attr_fg_color(this)               // ..use fg color for bg
-                 : u8c->attr_bg_color(this);              // ..use bg color for bg
+  for (int gcol=start_col; gcol<end_col; ) {              // walk runs of columns
+    // Find the run of chars with the same bg color
+    Fl_Color bg_col = draw_bg_color(grow, gcol, u8c);
+    int pwidth = 0;
+    do {
+      pwidth += pwidths[gcol - start_col];
+      gcol++; u8c++;
+    } while (gcol < end_col && draw_bg_color(grow, gcol, u8c) == bg_col);
     // Draw only if color != 0xffffffff ('see through' color) or widget's own color().
     if (bg_col != 0xffffffff && bg_col != Fl_Group::color()) {
       fl_color(bg_col);
       fl_rectf(X, bg_y, pwidth, bg_h);
     }
-    X += pwidth;                                          // advance X to next char
+    X += pwidth;                                          // advance X to next run
   }
 }
 
@@ -3628,13 +3758,27 @@ void Fl_Terminal::draw_row_bg(int grow, int X, int Y) const {
   Draw the specified global row, which is the row in ring_chars[].
   The global row includes history + display buffers.
 
+  Runs of chars with the same attributes and colors are drawn together:
+  the font and color are set once per run, and ASCII text is drawn as a
+  single string whenever the font places every char exactly in its column.
+
  \param[in] grow row number
  \param[in] Y top position of characters in the row in FLTK coordinates
 */
 void Fl_Terminal::draw_row(int grow, int Y) const {
+  int start_col = hscrollbar->visible() ? hscrollbar->value() : 0;
+  int end_col   = disp_cols();
+  if (start_col >= end_col) return;
+  // Measure the chars once for the background and the text
+  const Utf8Char *row = u8c_ring_row(grow);
+  row_scratch(end_col - start_col);
+  const int *pwidths = row_widths_;
+  char *text = row_text_;
+  measure_row(row + start_col, end_col - start_col, row_widths_);
+
   // Draw background color spans, if any
   int X = scrn_.x();
-  draw_row_bg(grow, X, Y);
+  draw_row_bg(grow, X, Y, pwidths);
 
   // Draw forground text
   int  baseline = Y + current_style_->fontheight() - current_style_->fontdescent();
@@ -3647,22 +3791,14 @@ void Fl_Terminal::draw_row(int grow, int Y) const {
 //  int  underline_y = baseline + (current_style_->fontheight() / 5);
   int  strikeout_y = baseline - (current_style_->fontheight() / 3);
   int  underline_y = baseline;
-  uchar lastattr = -1;
   bool  is_cursor;
   Fl_Color fg;
-  int start_col = hscrollbar->visible() ? hscrollbar->value() : 0;
-  int end_col   = disp_cols();
-  const Utf8Char *u8c = u8c_ring_row(grow) + start_col;
-  for (int gcol=start_col; gcol<end_col; gcol++,u8c++) {  // walk the columns
+  for (int gcol=start_col; gcol<end_col; ) {              // walk runs of columns
     const int &dcol = gcol;                               // dcol and gcol are the same
+    const Utf8Char *u8c = row + gcol;
+    int pwidth = pwidths[gcol - start_col];
     // Are we drawing the cursor? Only if inside display
     is_cursor = inside_display ? cursor_.is_rowcol(drow-scrollval, dcol) : 0;
-    // Attribute changed since last char?
-    if (u8c->attrib() != lastattr) {
-      u8c->fl_font_set(*current_style_);                  // pwidth_int() needs fl_font set
-      lastattr = u8c->attrib();
-    }
-    int pwidth = u8c->pwidth_int();
     // DRAW CURSOR BLOCK - TODO: support other cursor types?
     if (is_cursor) {
       int cx = X;
@@ -3673,27 +3809,60 @@ void Fl_Terminal::draw_row(int grow, int Y) const {
       if (Fl::focus() == this) fl_rectf(cx, cy, cw, ch);
       else                     fl_rect(cx, cy, cw, ch);
     }
+    // Find the run of chars drawn with the same font and color.
+    //    The cursor is always a run of its own.
+    fg = is_cursor ? cursorfgcolor() : draw_fg_color(grow, gcol, u8c);
+    int ecol = gcol + 1;
+    if (!is_cursor) {
+      while (ecol < end_col &&
+             row[ecol].attrib() == u8c->attrib() &&
+             !(inside_display && cursor_.is_rowcol(drow-scrollval, ecol)) &&
+             draw_fg_color(grow, ecol, row + ecol) == fg) {
+        pwidth += pwidths[ecol - start_col];
+        ecol++;
+      }
+    }
     // DRAW TEXT
     // 1) Color for text
-    if (is_cursor) fg = cursorfgcolor();                     // color for text under cursor
-    else fg = is_inside_selection(grow, gcol)                // text in mouse selection?
-      ? select_.selectionfgcolor()                           // ..use selection FG color
-      : (u8c->attrib() & Fl_Terminal::INVERSE)               // Inverse attrib?
-        ? u8c->attr_bg_color(this)                           // ..use char's bg color for fg
-        : u8c->attr_fg_color(this);                          // ..use char's fg color for fg
     fl_color(fg);
-    // 2) Font for text - already set by u8c->fl_font_set() in the above
-    if (is_cursor) {
-      fl_font(fl_font()|FL_BOLD, fl_size());      // force text under cursor BOLD
-      lastattr = -1;                              // (ensure font reset on next iter)
+    // 2) Font for text
+    u8c->fl_font_set(*current_style_);
+    if (is_cursor) fl_font(fl_font()|FL_BOLD, fl_size()); // force text under cursor BOLD
+    // 3) Draw text for the run. No need to draw spaces.
+    //    Stretches of ASCII chars with the same width are drawn as one string
+    //    if the font advances exactly one column per char.
+    int cx = X;
+    for (int col=gcol; col<ecol; ) {
+      const Utf8Char *c = row + col;
+      int cw = pwidths[col - start_col];
+      if (c->length() == 1 && (uchar)c->text_utf8()[0] < 0x80) {
+        // Collect the ASCII chars of the same width, drop trailing spaces
+        int n = 0, nchars = 0;
+        for (; col+n < ecol && c[n].length() == 1 && (uchar)c[n].text_utf8()[0] < 0x80 &&
+               pwidths[col+n - start_col] == cw; n++) {
+          text[n] = c[n].text_utf8()[0];
+          if (!c[n].is_char(' ')) nchars = n + 1;
+        }
+        if (nchars > 1 && fl_width(text, nchars) == double(nchars * cw)) {
+          fl_draw(text, nchars, cx, baseline);
+        } else {
+          for (int i=0; i<nchars; i++)
+            if (text[i] != ' ') fl_draw(text + i, 1, cx + i * cw, baseline);
+        }
+        col += n;
+        cx  += n * cw;
+      } else {
+        fl_draw(c->text_utf8(), c->length(), cx, baseline);
+        col++;
+        cx += cw;
+      }
     }
-    // 3) Draw text for UTF-8 char. No need to draw spaces
-    if (!u8c->is_char(' ')) fl_draw(u8c->text_utf8(), u8c->length(), X, baseline);
     // 4) Strike or underline?
     if (u8c->attrib() & Fl_Terminal::UNDERLINE) fl_line(X, underline_y, X+pwidth, underline_y);
     if (u8c->attrib() & Fl_Terminal::STRIKEOUT) fl_line(X, strikeout_y, X+pwidth, strikeout_y);
-    // Move to next char pixel position
+    // Move to next run pixel position
     X += pwidth;
+    gcol = ecol;
   }
 }
 
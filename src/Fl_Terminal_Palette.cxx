@@ -0,0 +1,97 @@
+//
+// Color palette for Fl_Terminal for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Terminal_Palette.H"
+
+
+Fl_Terminal_Palette *Fl_Terminal_Palette::instance_ = 0;
+
+
+// Index 0 is used by a default Utf8Char, see Utf8Char::Utf8Char()
+Fl_Terminal_Palette::Fl_Terminal_Palette() {
+  limit_ = 65536;
+  Entry e = { 0xffffff00, 0xffffffff };
+  entries_.push_back(e);
+  used_.push_back(true);
+  map_[key_(e.fg, e.bg)] = 0;
+}
+
+
+void Fl_Terminal_Palette::add_user(void (*cb)(void *data), void *data) {
+  User u = { cb, data };
+  instance()->users_.push_back(u);
+}
+
+
+void Fl_Terminal_Palette::remove_user(void *data) {
+  if (!instance_) return;
+  std::vector<User> &users = instance_->users_;
+  for (size_t i = 0; i < users.size(); i++) {
+    if (users[i].data == data) {
+      users.erase(users.begin() + i);
+      break;
+    }
+  }
+  if (users.empty()) {
+    delete instance_;
+    instance_ = 0;
+  }
+}
+
+
+unsigned Fl_Terminal_Palette::index(Fl_Color fg, Fl_Color bg) {
+  std::unordered_map<unsigned long long, unsigned>::const_iterator it =
+    map_.find(key_(fg, bg));
+  if (it != map_.end()) return it->second;
+  if (free_.empty() && entries_.size() >= limit_)
+    collect_();
+  unsigned i;
+  if (!free_.empty()) {
+    i = free_.back();
+    free_.pop_back();
+  } else {
+    i = (unsigned)entries_.size();
+    entries_.push_back(Entry());
+    used_.push_back(false);
+  }
+  entries_[i].fg = fg;
+  entries_[i].bg = bg;
+  used_[i] = true;
+  map_[key_(fg, bg)] = i;
+  return i;
+}
+
+
+// Free all entries that no terminal marks as used
+void Fl_Terminal_Palette::collect_() {
+  if (!users_.empty()) {
+    used_.assign(entries_.size(), false);
+    used_[0] = true;                    // never free index 0
+    for (size_t u = 0; u < users_.size(); u++)
+      users_[u].cb(users_[u].data);
+    free_.clear();
+    for (unsigned i = (unsigned)entries_.size() - 1; i > 0; i--) {
+      if (used_[i]) continue;
+      std::unordered_map<unsigned long long, unsigned>::iterator it =
+        map_.find(key_(entries_[i].fg, entries_[i].bg));
+      if (it != map_.end() && it->second == i) map_.erase(it);
+      free_.push_back(i);
+    }
+  }
+  // Grow if most pairs are still used, so the next collection frees enough
+  if (free_.size() < entries_.size() / 2)
+    limit_ *= 2;
+}
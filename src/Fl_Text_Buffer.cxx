@@ -23,6 +23,9 @@
 #include <FL/Fl.H>
 #include <FL/Fl_Text_Buffer.H>
 #include <FL/fl_ask.H>
+#include "Fl_Text_Piece_Table.H"
+#include "Fl_Text_Line_Index.H"
+#include "Fl_System_Driver.H"
 
 
 /*
@@ -204,13 +207,22 @@ static void def_transcoding_warning_action(Fl_Text_Buffer *text)
 /*
  Initialize all variables.
  */
-Fl_Text_Buffer::Fl_Text_Buffer(int requestedSize, int preferredGapSize)
+Fl_Text_Buffer::Fl_Text_Buffer(int requestedSize, int preferredGapSize,
+                               Storage storage)
 {
   mLength = 0;
   mPreferredGapSize = preferredGapSize;
-  mBuf = (char *) malloc(requestedSize + mPreferredGapSize);
-  mGapStart = 0;
-  mGapEnd = requestedSize + mPreferredGapSize;
+  if (storage == PIECE_TABLE) {
+    mPieces = new Fl_Text_Piece_Table();
+    mBuf = NULL;
+    mGapStart = mGapEnd = 0;
+  } else {
+    mPieces = NULL;
+    mBuf = (char *) malloc(requestedSize + mPreferredGapSize);
+    mGapStart = 0;
+    mGapEnd = requestedSize + mPreferredGapSize;
+  }
+  mLineIndex = NULL;
   mTabDist = 8;
   mPrimary.mSelected = 0;
   mPrimary.mStart = mPrimary.mEnd = 0;
@@ -240,6 +252,8 @@ Fl_Text_Buffer::Fl_Text_Buffer(int requestedSize, int preferredGapSize)
 Fl_Text_Buffer::~Fl_Text_Buffer()
 {
   free(mBuf);
+  delete mLineIndex;
+  delete mPieces;
   if (mNModifyProcs != 0) {
     delete[]mModifyProcs;
     delete[]mCbArgs;
@@ -260,8 +274,7 @@ Fl_Text_Buffer::~Fl_Text_Buffer()
  */
 char *Fl_Text_Buffer::text() const {
   char *t = (char *) malloc(mLength + 1);
-  memcpy(t, mBuf, mGapStart);
-  memcpy(t+mGapStart, mBuf+mGapEnd, mLength - mGapStart);
+  copy_range_(0, mLength, t);
   t[mLength] = '\0';
   return t;
 }
@@ -274,14 +287,59 @@ char *Fl_Text_Buffer::text() const {
 std::string Fl_Text_Buffer::text_str() const {
   std::string t;
   if (mLength) {
-    t.reserve(mLength);
-    t.insert(0, mBuf, mGapStart);
-    t.insert(mGapStart, mBuf+mGapEnd, mLength - mGapStart);
+    t.resize(mLength);
+    copy_range_(0, mLength, &t[0]);
   }
   return t;
 }
 
 
+/*
+ Return the address of a byte and the range of positions around it that are
+ contiguous in memory. For a gap buffer this is the text before or after the
+ gap, for a piece table it is the piece that contains pos.
+ */
+const char *Fl_Text_Buffer::span_(int pos, int &first, int &last) const {
+  if (mPieces)
+    return mPieces->span(pos, first, last);
+  if (pos < mGapStart) {
+    first = 0;
+    last = mGapStart;
+    return mBuf + pos;
+  }
+  first = mGapStart;
+  last = mLength;
+  return mBuf + pos + (mGapEnd - mGapStart);
+}
+
+
+/*
+ Copy a range of text, skipping the gap if there is one.
+ */
+void Fl_Text_Buffer::copy_range_(int start, int end, char *dst) const {
+  if (mPieces) {
+    mPieces->copy_out(start, end, dst);
+  } else if (end <= mGapStart) {
+    memcpy(dst, mBuf + start, end - start);
+  } else if (start >= mGapStart) {
+    memcpy(dst, mBuf + start + (mGapEnd - mGapStart), end - start);
+  } else {
+    int part1Length = mGapStart - start;
+    memcpy(dst, mBuf + start, part1Length);
+    memcpy(dst + part1Length, mBuf + mGapEnd, end - start - part1Length);
+  }
+}
+
+
+/*
+ Out of line part of address() for piece tables, so the inline part does
+ not depend on the internal Fl_Text_Piece_Table class.
+ */
+const char *Fl_Text_Buffer::piece_address_(int pos) const {
+  return mPieces->address(pos);
+}
+
+
 /*
  Set the text buffer to a new string.
  */
@@ -298,15 +356,22 @@ void Fl_Text_Buffer::text(const char *t)
   /* Save information for redisplay, and get rid of the old buffer */
   const char *deletedText = text();
   int deletedLength = mLength;
-  free((void *) mBuf);
-
-  /* Start a new buffer with a gap of mPreferredGapSize at the end */
   int insertedLength = (int) strlen(t);
-  mBuf = (char *) malloc(insertedLength + mPreferredGapSize);
   mLength = insertedLength;
-  mGapStart = insertedLength;
-  mGapEnd = mGapStart + mPreferredGapSize;
-  memcpy(mBuf, t, insertedLength);
+
+  if (mPieces) {
+    mPieces->clear();
+    mPieces->insert(0, t, insertedLength);
+  } else {
+    /* Start a new buffer with a gap of mPreferredGapSize at the end */
+    free((void *) mBuf);
+    mBuf = (char *) malloc(insertedLength + mPreferredGapSize);
+    mGapStart = insertedLength;
+    mGapEnd = mGapStart + mPreferredGapSize;
+    memcpy(mBuf, t, insertedLength);
+  }
+  if (mLineIndex)
+    mLineIndex->rebuild();
 
   /* Zero all of the existing selections */
   update_selections(0, deletedLength, 0);
@@ -351,15 +416,7 @@ char *Fl_Text_Buffer::text_range(int start, int end) const {
   s = (char *) malloc(copiedLength + 1);
 
   /* Copy the text from the buffer to the returned string */
-  if (end <= mGapStart) {
-    memcpy(s, mBuf + start, copiedLength);
-  } else if (start >= mGapStart) {
-    memcpy(s, mBuf + start + (mGapEnd - mGapStart), copiedLength);
-  } else {
-    int part1Length = mGapStart - start;
-    memcpy(s, mBuf + start, part1Length);
-    memcpy(s + part1Length, mBuf + mGapEnd, copiedLength - part1Length);
-  }
+  copy_range_(start, end, s);
   s[copiedLength] = '\0';
   return s;
 }
@@ -543,6 +600,18 @@ void Fl_Text_Buffer::copy(Fl_Text_Buffer * fromBuf, int fromStart,
 
   int copiedLength = fromEnd - fromStart;
 
+  if (mPieces) {
+    char *t = (char *) malloc(copiedLength);
+    fromBuf->copy_range_(fromStart, fromEnd, t);
+    mPieces->insert(toPos, t, copiedLength);
+    free(t);
+    mLength += copiedLength;
+    if (mLineIndex)
+      mLineIndex->inserted(toPos, copiedLength);
+    update_selections(toPos, 0, copiedLength);
+    return;
+  }
+
   /* Prepare the buffer to receive the new text.  If the new text fits in
    the current buffer, just move the gap (if necessary) to where
    the text should be inserted.  If the new text is too large, reallocate
@@ -554,20 +623,11 @@ void Fl_Text_Buffer::copy(Fl_Text_Buffer * fromBuf, int fromStart,
     move_gap(toPos);
 
   /* Insert the new text (toPos now corresponds to the start of the gap) */
-  if (fromEnd <= fromBuf->mGapStart) {
-    memcpy(&mBuf[toPos], &fromBuf->mBuf[fromStart], copiedLength);
-  } else if (fromStart >= fromBuf->mGapStart) {
-    memcpy(&mBuf[toPos],
-           &fromBuf->mBuf[fromStart + (fromBuf->mGapEnd - fromBuf->mGapStart)],
-           copiedLength);
-  } else {
-    int part1Length = fromBuf->mGapStart - fromStart;
-    memcpy(&mBuf[toPos], &fromBuf->mBuf[fromStart], part1Length);
-    memcpy(&mBuf[toPos + part1Length],
-           &fromBuf->mBuf[fromBuf->mGapEnd], copiedLength - part1Length);
-  }
+  fromBuf->copy_range_(fromStart, fromEnd, &mBuf[toPos]);
   mGapStart += copiedLength;
   mLength += copiedLength;
+  if (mLineIndex)
+    mLineIndex->inserted(toPos, copiedLength);
   update_selections(toPos, 0, copiedLength);
 }
 
@@ -1056,6 +1116,12 @@ char *Fl_Text_Buffer::line_text(int pos) const {
  */
 int Fl_Text_Buffer::line_start(int pos) const
 {
+  if (mLineIndex) {
+    if (pos > mLength)
+      pos = mLength;
+    int n = pos > 0 ? mLineIndex->lines_before(pos) : 0;
+    return n ? mLineIndex->line_position(n) : 0;
+  }
   if (!findchar_backward(pos, '\n', &pos))
     return 0;
   return pos + 1;
@@ -1066,6 +1132,12 @@ int Fl_Text_Buffer::line_start(int pos) const
  Find the end of the line.
  */
 int Fl_Text_Buffer::line_end(int pos) const {
+  if (mLineIndex) {
+    if (pos >= mLength)
+      return mLength;
+    int n = mLineIndex->lines_before(pos) + 1;
+    return n > mLineIndex->lines() ? mLength : mLineIndex->line_position(n) - 1;
+  }
   if (!findchar_forward(pos, '\n', &pos))
     pos = mLength;
   return pos;
@@ -1161,24 +1233,62 @@ int Fl_Text_Buffer::count_lines(int startPos, int endPos) const {
   IS_UTF8_ALIGNED2(this, (startPos))
   IS_UTF8_ALIGNED2(this, (endPos))
 
-  int gapLen = mGapEnd - mGapStart;
-  int lineCount = 0;
+  if (endPos < startPos || endPos > mLength)
+    endPos = mLength;
+  if (mLineIndex)
+    return mLineIndex->lines_before(endPos) - mLineIndex->lines_before(startPos);
+  return count_newlines_(startPos, endPos);
+}
 
-  int pos = startPos;
-  while (pos < mGapStart)
-  {
-    if (pos == endPos)
-      return lineCount;
-    if (mBuf[pos++] == '\n')
-      lineCount++;
+
+/*
+ Count the newlines between start and end by scanning the text.
+ */
+int Fl_Text_Buffer::count_newlines_(int start, int end) const {
+  int lineCount = 0;
+  int pos = start, first, last;
+  while (pos < end) {
+    const char *p = span_(pos, first, last);
+    if (last > end)
+      last = end;
+    for (const char *e = p + (last - pos); p < e; p++)
+      if (*p == '\n')
+        lineCount++;
+    pos = last;
   }
+  return lineCount;
+}
+
+
+/*
+ Find the n-th newline at or after start by scanning the text.
+ */
+int Fl_Text_Buffer::find_newline_(int start, int n) const {
+  int pos = start, first, last;
   while (pos < mLength) {
-    if (pos == endPos)
-      return lineCount;
-    if (mBuf[pos++ + gapLen] == '\n')
-      lineCount++;
+    const char *p = span_(pos, first, last);
+    const char *e = p + (last - pos);
+    while ((p = (const char *)memchr(p, '\n', e - p)) != NULL) {
+      if (--n == 0)
+        return last - (int)(e - p);
+      p++;
+    }
+    pos = last;
+  }
+  return mLength;
+}
+
+
+/*
+ Enable or disable the line index.
+ */
+void Fl_Text_Buffer::line_index(bool on) {
+  if (on && !mLineIndex) {
+    mLineIndex = new Fl_Text_Line_Index(this);
+  } else if (!on && mLineIndex) {
+    delete mLineIndex;
+    mLineIndex = NULL;
   }
-  return lineCount;
 }
 
 /**
@@ -1191,35 +1301,27 @@ int Fl_Text_Buffer::estimate_lines(int startPos, int endPos, int lineLen) const
   IS_UTF8_ALIGNED2(this, (startPos))
   IS_UTF8_ALIGNED2(this, (endPos))
 
-  int gapLen = mGapEnd - mGapStart;
   int lineCount = 0;
   int softLineBreaks = 0, softLineBreakCount = lineLen;
 
-  int pos = startPos;
-  while (pos < mGapStart)
-  {
-    if (pos == endPos)
-      return lineCount + softLineBreaks;
-    if (mBuf[pos++] == '\n') {
-      softLineBreakCount = lineLen;
-      lineCount++;
-    }
-    if (--softLineBreakCount == 0) {
-      softLineBreakCount = lineLen;
-      softLineBreaks++;
-    }
-  }
-  while (pos < mLength) {
-    if (pos == endPos)
-      return lineCount + softLineBreaks;
-    if (mBuf[pos++ + gapLen] == '\n') {
-      softLineBreakCount = lineLen;
-      lineCount++;
-    }
-    if (--softLineBreakCount == 0) {
-      softLineBreakCount = lineLen;
-      softLineBreaks++;
+  if (endPos < startPos || endPos > mLength)
+    endPos = mLength;
+  int pos = startPos, first, last;
+  while (pos < endPos) {
+    const char *p = span_(pos, first, last);
+    if (last > endPos)
+      last = endPos;
+    for (const char *e = p + (last - pos); p < e; p++) {
+      if (*p == '\n') {
+        softLineBreakCount = lineLen;
+        lineCount++;
+      }
+      if (--softLineBreakCount == 0) {
+        softLineBreakCount = lineLen;
+        softLineBreaks++;
+      }
     }
+    pos = last;
   }
   return lineCount + softLineBreaks;
 }
@@ -1236,24 +1338,21 @@ int Fl_Text_Buffer::skip_lines(int startPos, int nLines)
   if (nLines == 0)
     return startPos;
 
-  int gapLen = mGapEnd - mGapStart;
-  int pos = startPos;
+  if (mLineIndex && nLines > 0 && startPos < mLength)
+    return mLineIndex->line_position(mLineIndex->lines_before(startPos) + nLines);
+
+  int pos = startPos, first, last;
   int lineCount = 0;
-  while (pos < mGapStart) {
-    if (mBuf[pos++] == '\n') {
-      lineCount++;
-      if (lineCount == nLines) {
-        IS_UTF8_ALIGNED2(this, (pos))
-        return pos;
-      }
-    }
-  }
   while (pos < mLength) {
-    if (mBuf[pos++ + gapLen] == '\n') {
-      lineCount++;
-      if (lineCount >= nLines) {
-        IS_UTF8_ALIGNED2(this, (pos))
-        return pos;
+    const char *p = span_(pos, first, last);
+    while (pos < last) {
+      pos++;
+      if (*p++ == '\n') {
+        lineCount++;
+        if (lineCount >= nLines) {
+          IS_UTF8_ALIGNED2(this, (pos))
+          return pos;
+        }
       }
     }
   }
@@ -1275,25 +1374,26 @@ int Fl_Text_Buffer::rewind_lines(int startPos, int nLines)
   if (pos <= 0)
     return 0;
 
-  int gapLen = mGapEnd - mGapStart;
-  int lineCount = -1;
-  while (pos >= mGapStart) {
-    if (mBuf[pos + gapLen] == '\n') {
-      if (++lineCount >= nLines) {
-        IS_UTF8_ALIGNED2(this, (pos+1))
-        return pos + 1;
-      }
-    }
-    pos--;
+  if (pos >= mLength)
+    pos = mLength - 1;
+
+  if (mLineIndex && nLines >= 0) {
+    int n = mLineIndex->lines_before(pos + 1) - nLines;
+    return n > 0 ? mLineIndex->line_position(n) : 0;
   }
+
+  int lineCount = -1, first, last;
   while (pos >= 0) {
-    if (mBuf[pos] == '\n') {
-      if (++lineCount >= nLines) {
-        IS_UTF8_ALIGNED2(this, (pos+1))
-        return pos + 1;
+    const char *p = span_(pos, first, last);
+    while (pos >= first) {
+      if (*p-- == '\n') {
+        if (++lineCount >= nLines) {
+          IS_UTF8_ALIGNED2(this, (pos+1))
+          return pos + 1;
+        }
       }
+      pos--;
     }
-    pos--;
   }
   return 0;
 }
@@ -1419,20 +1519,26 @@ int Fl_Text_Buffer::insert_(int pos, const char *text, int insertedLength)
 
   if (insertedLength == -1) insertedLength = (int) strlen(text);
 
-  /* Prepare the buffer to receive the new text.  If the new text fits in
-   the current buffer, just move the gap (if necessary) to where
-   the text should be inserted.  If the new text is too large, reallocate
-   the buffer with a gap large enough to accomodate the new text and a
-   gap of mPreferredGapSize */
-  if (insertedLength > mGapEnd - mGapStart)
-    reallocate_with_gap(pos, insertedLength + mPreferredGapSize);
-  else if (pos != mGapStart)
-    move_gap(pos);
-
-  /* Insert the new text (pos now corresponds to the start of the gap) */
-  memcpy(&mBuf[pos], text, insertedLength);
-  mGapStart += insertedLength;
+  if (mPieces) {
+    mPieces->insert(pos, text, insertedLength);
+  } else {
+    /* Prepare the buffer to receive the new text.  If the new text fits in
+     the current buffer, just move the gap (if necessary) to where
+     the text should be inserted.  If the new text is too large, reallocate
+     the buffer with a gap large enough to accomodate the new text and a
+     gap of mPreferredGapSize */
+    if (insertedLength > mGapEnd - mGapStart)
+      reallocate_with_gap(pos, insertedLength + mPreferredGapSize);
+    else if (pos != mGapStart)
+      move_gap(pos);
+
+    /* Insert the new text (pos now corresponds to the start of the gap) */
+    memcpy(&mBuf[pos], text, insertedLength);
+    mGapStart += insertedLength;
+  }
   mLength += insertedLength;
+  if (mLineIndex)
+    mLineIndex->inserted(pos, insertedLength);
   update_selections(pos, 0, insertedLength);
 
   if (mCanUndo) {
@@ -1487,26 +1593,24 @@ void Fl_Text_Buffer::remove_(int start, int end)
     mUndo->undoyankcut = 0;
   }
 
-  if (start > mGapStart) {
-    if (mCanUndo)
-      memcpy(mUndo->undobuffer, mBuf + (mGapEnd - mGapStart) + start,
-             end - start);
-    move_gap(start);
-  } else if (end < mGapStart) {
-    if (mCanUndo)
-      memcpy(mUndo->undobuffer, mBuf + start, end - start);
-    move_gap(end);
+  if (mCanUndo)
+    copy_range_(start, end, mUndo->undobuffer);
+
+  if (mLineIndex)
+    mLineIndex->removing(start, end);
+
+  if (mPieces) {
+    mPieces->remove(start, end);
   } else {
-    int prelen = mGapStart - start;
-    if (mCanUndo) {
-      memcpy(mUndo->undobuffer, mBuf + start, prelen);
-      memcpy(mUndo->undobuffer + prelen, mBuf + mGapEnd, end - start - prelen);
-    }
-  }
+    if (start > mGapStart)
+      move_gap(start);
+    else if (end < mGapStart)
+      move_gap(end);
 
-  /* expand the gap to encompass the deleted characters */
-  mGapEnd += end - mGapStart;
-  mGapStart = start;
+    /* expand the gap to encompass the deleted characters */
+    mGapEnd += end - mGapStart;
+    mGapStart = start;
+  }
 
   /* update the length */
   mLength -= end - start;
@@ -2057,6 +2161,47 @@ const char *Fl_Text_Buffer::file_encoding_warning_message =
 }
 
 
+/*
+ Load a file by mapping it into memory.
+ */
+int Fl_Text_Buffer::mapfile(const char *file)
+{
+  size_t size = 0;
+  void *addr = mPieces ? Fl::system_driver()->map_file(file, &size) : NULL;
+  if (!addr)
+    return loadfile(file);
+  if (size > 0x7fffffff) {      // positions are int
+    Fl::system_driver()->unmap_file(addr, size);
+    return 1;
+  }
+
+  call_predelete_callbacks(0, length());
+
+  /* Save information for redisplay, and replace the storage */
+  const char *deletedText = text();
+  int deletedLength = mLength;
+  mPieces->map(addr, size);
+  mLength = (int)size;
+  if (mLineIndex)
+    mLineIndex->rebuild();
+  input_file_was_transcoded = 0;
+
+  /* Zero all of the existing selections */
+  update_selections(0, deletedLength, 0);
+
+  /* Call the saved display routine(s) to update the screen */
+  call_modify_callbacks(0, deletedLength, mLength, 0, deletedText);
+  free((void *) deletedText);
+
+  if (mCanUndo) {
+    mUndo->clear();
+    mUndoList->clear();
+    mRedoList->clear();
+  }
+  return 0;
+}
+
+
 /*
  Write text to file.
  Unicode safe.
@@ -33,6 +33,7 @@
 #include <FL/Fl_Menu_Item.H>
 #include <FL/Fl_Input.H>
 #include "Fl_Screen_Driver.H"
+#include "Fl_Text_Wrap_Cache.H"
 
 #undef min
 #undef max
@@ -151,6 +152,7 @@ Fl_Text_Display::Fl_Text_Display(int X, int Y, int W, int H, const char* l)
   mNLinesDeleted = 0;
   mModifyingTabDistance = 0;    // XXX: UNUSED
   mColumnScale = 0;
+  mWrapCache = new Fl_Text_Wrap_Cache;
   mCursor_color = FL_FOREGROUND_COLOR;
 
   mHScrollBar = new Fl_Scrollbar(0,0,1,1);
@@ -221,6 +223,7 @@ Fl_Text_Display::~Fl_Text_Display() {
     mBuffer->remove_predelete_callback(buffer_predelete_cb, this);
   }
   if (mLineStarts) delete[] mLineStarts;
+  delete mWrapCache;
   if (linenumber_format_) {
     free((void*)linenumber_format_);
     linenumber_format_ = 0;
@@ -383,6 +386,7 @@ void Fl_Text_Display::buffer( Fl_Text_Buffer *buf ) {
   /* Add the buffer to the display, and attach a callback to the buffer for
    receiving modification information when the buffer contents change */
   mBuffer = buf;
+  mWrapCache->clear();
   if (mBuffer) {
     mBuffer->add_modify_callback( buffer_modified_cb, this );
     mBuffer->add_predelete_callback( buffer_predelete_cb, this );
@@ -449,6 +453,7 @@ void Fl_Text_Display::highlight_data(Fl_Text_Buffer *styleBuffer,
   mUnfinishedHighlightCB = unfinishedHighlightCB;
   mHighlightCBArg = cbArg;
   mColumnScale = 0;
+  mWrapCache->invalidate(0, INT_MAX);
 
   if (mStyleBuffer)
     mStyleBuffer->canUndo(0);
@@ -764,7 +769,8 @@ void Fl_Text_Display::draw_text( int left, int top, int width, int height ) {
  \brief Marks text from start to end as needing a redraw.
 
  This function will trigger a damage event and later a redraw of parts of
- the widget.
+ the widget. Call it after changing the style buffer (see highlight_data()),
+ so that the wrapped lines of the range are counted again.
  \param startpos index of first character needing redraw
  \param endpos index after last character needing redraw
  */
@@ -786,6 +792,9 @@ void Fl_Text_Display::redisplay_range(int startpos, int endpos) {
     damage_range2_start = min(damage_range2_start, startpos);
     damage_range2_end = max(damage_range2_end, endpos);
   }
+  // The style of the range may have changed, and with it its wrapped lines
+  if (mStyleBuffer)
+    mWrapCache->invalidate(startpos, endpos);
   damage(FL_DAMAGE_SCROLL);
 }
 
@@ -1467,36 +1476,20 @@ int Fl_Text_Display::count_lines(int startPos, int endPos,
    buffer stays intact as well as the scroll position.
    */
   if (buffer()->length() > 16384) {
-    // Optimized line counting
-    int nLines = 0;
+    // Optimized line counting: whole blocks of lines use their cached count
+    mWrapCache->layout(mWrapMarginPix ? mWrapMarginPix : text_area.w,
+                       textfont(), textsize(), mStyleTable, mNStyles);
+    if (!mWrapCache->built())
+      mWrapCache->build(buffer());
+    int first = mWrapCache->find(startPos), last = mWrapCache->find(endPos);
+    if (first == last)
+      return count_wrapped_lines_(startPos, endPos, startPosIsLineStart);
     int firstVisibleChar = buffer()->rewind_lines(mFirstChar, 3);
     int lastVisibleChar = buffer()->skip_lines(mLastChar, 3);
-    // Calculate the averga number of characters up to a soft line break
-    if (mColumnScale==0.0) x_to_col(1.0);
-    int avgCharsPerLine = mWrapMarginPix;
-    if (!avgCharsPerLine) avgCharsPerLine = text_area.w;
-    avgCharsPerLine = (int)(avgCharsPerLine / mColumnScale) + 1;
-
-    // first segment, lines up to display, count fast
-    if (startPos < firstVisibleChar) {
-      int tmpEnd = endPos<firstVisibleChar ? endPos : firstVisibleChar;
-      nLines += buffer()->estimate_lines(startPos, tmpEnd, avgCharsPerLine);
-      startPos = tmpEnd;
-    }
-    // second segement, count displayed liens
-    if (startPos < endPos && startPos < mLastChar) {
-      // Precisse line counting only for visible text:
-      int tmpEnd = endPos<lastVisibleChar ? endPos : lastVisibleChar;
-      wrapped_line_counter(buffer(), startPos, tmpEnd, INT_MAX,
-                           startPosIsLineStart, 0, &retPos, &retLines, &retLineStart,
-                           &retLineEnd);
-      nLines += retLines;
-      startPos = tmpEnd;
-    }
-    // third segement is everything after displayed lines
-    if (startPos < endPos && startPos >= lastVisibleChar) {
-      nLines += buffer()->estimate_lines(startPos, endPos, avgCharsPerLine);
-    }
+    int nLines = count_wrapped_lines_(startPos, mWrapCache->end(first), startPosIsLineStart);
+    for (int i = first + 1; i < last; i++)
+      nLines += count_block_lines_(i, firstVisibleChar, lastVisibleChar);
+    nLines += count_wrapped_lines_(mWrapCache->start(last), endPos, true);
     return nLines;
   } else {
     // Precise line counting only for small text buffer sizes:
@@ -1513,6 +1506,86 @@ int Fl_Text_Display::count_lines(int startPos, int endPos,
 }
 
 
+/**
+ \brief Count the wrapped lines between two positions of a large buffer.
+
+ Counts the lines of the visible text (plus minus a few lines for rounding)
+ precisely and estimates the number of lines of all other text, see
+ count_lines().
+
+ \param startPos index to first character
+ \param endPos index after last character
+ \param startPosIsLineStart avoid scanning back to the line start
+ \return number of lines
+ */
+int Fl_Text_Display::count_wrapped_lines_(int startPos, int endPos,
+                                          bool startPosIsLineStart) const {
+  int retLines, retPos, retLineStart, retLineEnd;
+  int nLines = 0;
+  int firstVisibleChar = buffer()->rewind_lines(mFirstChar, 3);
+  int lastVisibleChar = buffer()->skip_lines(mLastChar, 3);
+  // Calculate the averga number of characters up to a soft line break
+  if (mColumnScale==0.0) x_to_col(1.0);
+  int avgCharsPerLine = mWrapMarginPix;
+  if (!avgCharsPerLine) avgCharsPerLine = text_area.w;
+  avgCharsPerLine = (int)(avgCharsPerLine / mColumnScale) + 1;
+
+  // first segment, lines up to display, count fast
+  if (startPos < firstVisibleChar) {
+    int tmpEnd = endPos<firstVisibleChar ? endPos : firstVisibleChar;
+    nLines += buffer()->estimate_lines(startPos, tmpEnd, avgCharsPerLine);
+    startPos = tmpEnd;
+  }
+  // second segement, count displayed liens
+  if (startPos < endPos && startPos < mLastChar) {
+    // Precisse line counting only for visible text:
+    int tmpEnd = endPos<lastVisibleChar ? endPos : lastVisibleChar;
+    wrapped_line_counter(buffer(), startPos, tmpEnd, INT_MAX,
+                         startPosIsLineStart, 0, &retPos, &retLines, &retLineStart,
+                         &retLineEnd);
+    nLines += retLines;
+    startPos = tmpEnd;
+  }
+  // third segement is everything after displayed lines
+  if (startPos < endPos && startPos >= lastVisibleChar) {
+    nLines += buffer()->estimate_lines(startPos, endPos, avgCharsPerLine);
+  }
+  return nLines;
+}
+
+
+/**
+ \brief Return the number of wrapped lines of a block of the line cache.
+
+ Blocks near the visible text are measured precisely, all other blocks are
+ estimated. Both results are stored in the cache, but an estimate is
+ replaced by the precise count as soon as the block comes into view.
+
+ \param block index of the block in the cache
+ \param firstVisibleChar, lastVisibleChar range that is counted precisely
+ \return number of lines
+ */
+int Fl_Text_Display::count_block_lines_(int block, int firstVisibleChar,
+                                        int lastVisibleChar) const {
+  int start = mWrapCache->start(block), end = mWrapCache->end(block);
+  bool visible = end > firstVisibleChar && start < lastVisibleChar;
+  if (mWrapCache->lines(block) >= 0 && (mWrapCache->exact(block) || !visible))
+    return mWrapCache->lines(block);
+  int nLines;
+  // Don't measure a single huge line, the old estimate is as good as any
+  if (visible && mWrapCache->bytes(block) <= 4 * Fl_Text_Wrap_Cache::block_size) {
+    int retPos, retLineStart, retLineEnd;
+    wrapped_line_counter(buffer(), start, end, INT_MAX, true, 0,
+                         &retPos, &nLines, &retLineStart, &retLineEnd);
+    mWrapCache->lines(block, nLines, true);
+  } else {
+    nLines = count_wrapped_lines_(start, end, true);
+    mWrapCache->lines(block, nLines, false);
+  }
+  return nLines;
+}
+
+
 
 /**
  \brief Skip a number of lines forward.
@@ -1772,6 +1845,9 @@ void Fl_Text_Display::buffer_modified_cb( int pos, int nInserted, int nDeleted,
   if ( nInserted != 0 || nDeleted != 0 )
     textD->mCursorPreferredXPos = -1;
 
+  /* forget the cached line counts of the modified text */
+  textD->mWrapCache->modified(buf, pos, nInserted, nDeleted);
+
   /* Count the number of lines inserted and deleted, and in the case
    of continuous wrap mode, how much has changed */
   if (textD->mContinuousWrap) {
@@ -0,0 +1,228 @@
+//
+// Line index for Fl_Text_Buffer for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Text_Line_Index.H"
+#include <FL/Fl_Text_Buffer.H>
+
+// Maximum number of bytes in a chunk. Queries scan at most one chunk.
+static const int chunk_size = 4096;
+
+
+Fl_Text_Line_Index::Fl_Text_Line_Index(const Fl_Text_Buffer *buf)
+  : buf_(buf),
+    root_(0),
+    seed_(0x2545F491)
+{
+  rebuild();
+}
+
+
+Fl_Text_Line_Index::~Fl_Text_Line_Index() {
+  free_tree_(root_);
+}
+
+
+/*
+ Xorshift generator for node priorities.
+ */
+unsigned Fl_Text_Line_Index::random_() {
+  seed_ ^= seed_ << 13;
+  seed_ ^= seed_ >> 17;
+  seed_ ^= seed_ << 5;
+  return seed_;
+}
+
+
+Fl_Text_Line_Index::Node *Fl_Text_Line_Index::new_node_(int len, int nl) {
+  Node *n = new Node;
+  n->left = n->right = 0;
+  n->len = n->sum = len;
+  n->nl = n->sumnl = nl;
+  n->prio = random_();
+  return n;
+}
+
+
+void Fl_Text_Line_Index::free_tree_(Node *n) {
+  while (n) {
+    free_tree_(n->left);
+    Node *r = n->right;
+    delete n;
+    n = r;
+  }
+}
+
+
+/*
+ Join two trees. All chunks of a come before all chunks of b.
+ */
+Fl_Text_Line_Index::Node *Fl_Text_Line_Index::merge_(Node *a, Node *b) {
+  if (!a) return b;
+  if (!b) return a;
+  if (a->prio >= b->prio) {
+    a->right = merge_(a->right, b);
+    update_(a);
+    return a;
+  }
+  b->left = merge_(a, b->left);
+  update_(b);
+  return b;
+}
+
+
+/*
+ Split a tree into the first pos bytes (l) and the rest (r). base is the
+ buffer position of the first byte of t. A chunk that straddles pos is cut
+ in two, and the newlines of the first part are counted in the buffer.
+ */
+void Fl_Text_Line_Index::split_(Node *t, int pos, int base, Node *&l, Node *&r) {
+  if (!t) {
+    l = r = 0;
+    return;
+  }
+  int ls = sum_(t->left);
+  if (pos <= ls) {
+    split_(t->left, pos, base, l, t->left);
+    update_(t);
+    r = t;
+  } else if (pos >= ls + t->len) {
+    split_(t->right, pos - ls - t->len, base + ls + t->len, t->right, r);
+    update_(t);
+    l = t;
+  } else {
+    int start = base + ls, off = pos - ls;
+    int nl = buf_->count_newlines_(start, start + off);
+    Node *n = new Node;
+    n->left = 0;
+    n->right = t->right;
+    n->len = t->len - off;
+    n->nl = t->nl - nl;
+    n->prio = t->prio;
+    t->len = off;
+    t->nl = nl;
+    t->right = 0;
+    update_(n);
+    update_(t);
+    l = t;
+    r = n;
+  }
+}
+
+
+/*
+ Create the chunks for the bytes between start and end.
+ */
+Fl_Text_Line_Index::Node *Fl_Text_Line_Index::build_(int start, int end) {
+  Node *t = 0;
+  for (int pos = start; pos < end; pos += chunk_size) {
+    int n = end - pos < chunk_size ? end - pos : chunk_size;
+    t = merge_(t, new_node_(n, buf_->count_newlines_(pos, pos + n)));
+  }
+  return t;
+}
+
+
+/*
+ Join two trees and combine the chunks at the seam if they are small enough.
+ This keeps the number of chunks proportional to the buffer size even if
+ the text is edited one character at a time.
+ */
+Fl_Text_Line_Index::Node *Fl_Text_Line_Index::join_(Node *a, Node *b) {
+  if (!a) return b;
+  if (!b) return a;
+  Node *x = a, *y = b;
+  while (x->right) x = x->right;
+  while (y->left) y = y->left;
+  if (x->len + y->len > chunk_size)
+    return merge_(a, b);
+  int len = x->len + y->len, nl = x->nl + y->nl;
+  Node *tail, *head;
+  split_(a, a->sum - x->len, 0, a, tail);  // splits at chunk boundaries,
+  split_(b, y->len, 0, head, b);           // no need to scan the buffer
+  free_tree_(tail);
+  free_tree_(head);
+  return merge_(merge_(a, new_node_(len, nl)), b);
+}
+
+
+void Fl_Text_Line_Index::rebuild() {
+  free_tree_(root_);
+  root_ = build_(0, buf_->length());
+}
+
+
+void Fl_Text_Line_Index::inserted(int pos, int len) {
+  if (len <= 0) return;
+  Node *l, *r;
+  split_(root_, pos, 0, l, r);
+  root_ = join_(join_(l, build_(pos, pos + len)), r);
+}
+
+
+void Fl_Text_Line_Index::removing(int start, int end) {
+  if (start >= end) return;
+  Node *l, *m, *r;
+  split_(root_, start, 0, l, m);
+  split_(m, end - start, start, m, r);
+  free_tree_(m);
+  root_ = join_(l, r);
+}
+
+
+int Fl_Text_Line_Index::lines_before(int pos) const {
+  if (pos <= 0) return 0;
+  if (pos >= sum_(root_)) return sumnl_(root_);
+  const Node *n = root_;
+  int base = 0, nl = 0;
+  while (n) {
+    int ls = sum_(n->left);
+    if (pos < base + ls) {
+      n = n->left;
+    } else if (pos >= base + ls + n->len) {
+      base += ls + n->len;
+      nl += sumnl_(n->left) + n->nl;
+      n = n->right;
+    } else {
+      base += ls;
+      nl += sumnl_(n->left);
+      break;
+    }
+  }
+  return nl + buf_->count_newlines_(base, pos);
+}
+
+
+int Fl_Text_Line_Index::line_position(int n) const {
+  if (n < 1) return 0;
+  if (n > sumnl_(root_)) return buf_->length();
+  const Node *t = root_;
+  int base = 0;
+  while (t) {
+    int ln = sumnl_(t->left);
+    if (n <= ln) {
+      t = t->left;
+    } else if (n > ln + t->nl) {
+      n -= ln + t->nl;
+      base += sum_(t->left) + t->len;
+      t = t->right;
+    } else {
+      base += sum_(t->left);
+      n -= ln;
+      break;
+    }
+  }
+  return buf_->find_newline_(base, n) + 1;
+}
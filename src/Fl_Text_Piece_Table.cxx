@@ -0,0 +1,274 @@
+//
+// Piece table text storage for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Text_Piece_Table.H"
+#include "Fl_System_Driver.H"
+#include <FL/Fl.H>
+
+#include <stdlib.h>
+#include <string.h>
+
+// Minimal size of a storage block for inserted text. Larger insertions
+// get a block of their own.
+static const int block_size = 64 * 1024;
+
+// Returned for positions at or beyond the end of the text.
+static const char empty_text[4] = { 0, 0, 0, 0 };
+
+
+Fl_Text_Piece_Table::Fl_Text_Piece_Table()
+  : root_(0),
+    blocks_(0),
+    seed_(0x2545F491),
+    map_addr_(0),
+    map_size_(0),
+    cache_text_(0),
+    cache_start_(0),
+    cache_end_(0)
+{
+}
+
+
+Fl_Text_Piece_Table::~Fl_Text_Piece_Table() {
+  clear();
+}
+
+
+void Fl_Text_Piece_Table::clear() {
+  free_tree_(root_);
+  root_ = 0;
+  while (blocks_) {
+    Block *b = blocks_->next;
+    ::free(blocks_);
+    blocks_ = b;
+  }
+  if (map_addr_) {
+    Fl::system_driver()->unmap_file(map_addr_, map_size_);
+    map_addr_ = 0;
+    map_size_ = 0;
+  }
+  invalidate_();
+}
+
+
+void Fl_Text_Piece_Table::map(void *addr, size_t size) {
+  clear();
+  map_addr_ = addr;
+  map_size_ = size;
+  if (size > 0)
+    root_ = new_node_((const char *)addr, (int)size, random_());
+}
+
+
+/*
+ Xorshift generator for node priorities. The quality of the numbers only
+ affects the expected depth of the tree, not its correctness.
+ */
+unsigned Fl_Text_Piece_Table::random_() {
+  seed_ ^= seed_ << 13;
+  seed_ ^= seed_ >> 17;
+  seed_ ^= seed_ << 5;
+  return seed_;
+}
+
+
+Fl_Text_Piece_Table::Node *Fl_Text_Piece_Table::new_node_(const char *text, int len, unsigned prio) {
+  Node *n = new Node;
+  n->left = n->right = 0;
+  n->text = text;
+  n->len = n->sum = len;
+  n->prio = prio;
+  return n;
+}
+
+
+void Fl_Text_Piece_Table::free_tree_(Node *n) {
+  while (n) {
+    free_tree_(n->left);
+    Node *r = n->right;
+    delete n;
+    n = r;
+  }
+}
+
+
+/*
+ Join two trees. All pieces of a come before all pieces of b.
+ */
+Fl_Text_Piece_Table::Node *Fl_Text_Piece_Table::merge_(Node *a, Node *b) {
+  if (!a) return b;
+  if (!b) return a;
+  if (a->prio >= b->prio) {
+    a->right = merge_(a->right, b);
+    update_(a);
+    return a;
+  }
+  b->left = merge_(a, b->left);
+  update_(b);
+  return b;
+}
+
+
+/*
+ Split a tree into the first pos bytes (l) and the rest (r). A piece that
+ straddles pos is cut in two. The new node inherits the priority of the
+ original node which keeps the heap order intact.
+ */
+void Fl_Text_Piece_Table::split_(Node *t, int pos, Node *&l, Node *&r) {
+  if (!t) {
+    l = r = 0;
+    return;
+  }
+  int ls = sum_(t->left);
+  if (pos <= ls) {
+    split_(t->left, pos, l, t->left);
+    update_(t);
+    r = t;
+  } else if (pos >= ls + t->len) {
+    split_(t->right, pos - ls - t->len, t->right, r);
+    update_(t);
+    l = t;
+  } else {
+    int off = pos - ls;
+    Node *n = new Node;
+    n->left = 0;
+    n->right = t->right;
+    n->text = t->text + off;
+    n->len = t->len - off;
+    n->prio = t->prio;
+    t->len = off;
+    t->right = 0;
+    update_(n);
+    update_(t);
+    l = t;
+    r = n;
+  }
+}
+
+
+/*
+ Append text to the last piece of the tree if the piece ends exactly where
+ text starts in the storage block. This keeps the number of pieces low when
+ the user types sequentially.
+ */
+bool Fl_Text_Piece_Table::extend_last_(Node *n, const char *text, int len) {
+  if (!n) return false;
+  if (n->right) {
+    if (!extend_last_(n->right, text, len)) return false;
+  } else {
+    if (n->text + n->len != text) return false;
+    n->len += len;
+  }
+  n->sum += len;
+  return true;
+}
+
+
+/*
+ Copy text into the storage blocks and return its stable address.
+ */
+const char *Fl_Text_Piece_Table::store_(const char *text, int len) {
+  Block *b = blocks_;
+  if (!b || b->size - b->used < len) {
+    int size = len > block_size ? len : block_size;
+    b = (Block *)::malloc(sizeof(Block) + size);
+    b->next = blocks_;
+    b->size = size;
+    b->used = 0;
+    blocks_ = b;
+  }
+  char *dst = b->data() + b->used;
+  memcpy(dst, text, len);
+  b->used += len;
+  return dst;
+}
+
+
+void Fl_Text_Piece_Table::insert(int pos, const char *text, int len) {
+  if (len <= 0) return;
+  if (pos < 0) pos = 0;
+  if (pos > length()) pos = length();
+  invalidate_();
+  const char *stored = store_(text, len);
+  Node *l, *r;
+  split_(root_, pos, l, r);
+  if (!extend_last_(l, stored, len))
+    l = merge_(l, new_node_(stored, len, random_()));
+  root_ = merge_(l, r);
+}
+
+
+void Fl_Text_Piece_Table::remove(int start, int end) {
+  if (start < 0) start = 0;
+  if (end > length()) end = length();
+  if (start >= end) return;
+  invalidate_();
+  Node *l, *m, *r;
+  split_(root_, start, l, m);
+  split_(m, end - start, m, r);
+  free_tree_(m);
+  root_ = merge_(l, r);
+}
+
+
+const char *Fl_Text_Piece_Table::span(int pos, int &first, int &last) const {
+  const Node *n = root_;
+  int base = 0;
+  if (pos < 0 || pos >= length()) {
+    first = last = length();
+    return empty_text;
+  }
+  while (n) {
+    int ls = sum_(n->left);
+    if (pos < base + ls) {
+      n = n->left;
+    } else if (pos >= base + ls + n->len) {
+      base += ls + n->len;
+      n = n->right;
+    } else {
+      base += ls;
+      break;
+    }
+  }
+  first = base;
+  last = base + n->len;
+  cache_text_ = n->text;
+  cache_start_ = first;
+  cache_end_ = last;
+  return n->text + (pos - base);
+}
+
+
+void Fl_Text_Piece_Table::copy_out(int start, int end, char *dst) const {
+  while (start < end) {
+    int first, last;
+    const char *src = span(start, first, last);
+    int n = (last < end ? last : end) - start;
+    memcpy(dst, src, n);
+    dst += n;
+    start += n;
+  }
+}
+
+
+int Fl_Text_Piece_Table::count_(const Node *n) {
+  return n ? 1 + count_(n->left) + count_(n->right) : 0;
+}
+
+
+int Fl_Text_Piece_Table::pieces() const {
+  return count_(root_);
+}
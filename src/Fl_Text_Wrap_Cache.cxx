@@ -0,0 +1,135 @@
+//
+// Wrapped line cache for Fl_Text_Display for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Text_Wrap_Cache.H"
+#include <FL/Fl_Text_Buffer.H>
+
+#include <algorithm>
+
+
+Fl_Text_Wrap_Cache::Fl_Text_Wrap_Cache()
+  : starts_valid_(false),
+    margin_(0),
+    font_(0),
+    size_(0),
+    styles_(0),
+    nstyles_(0)
+{
+}
+
+
+void Fl_Text_Wrap_Cache::clear() {
+  blocks_.clear();
+  starts_.clear();
+  starts_valid_ = false;
+}
+
+
+/*
+ Divide the text between start and end into blocks and append them to out.
+ end must be a line start or the end of the buffer. The last block gets
+ the rest of the text if that is less than half a block.
+ */
+void Fl_Text_Wrap_Cache::chunk_(const Fl_Text_Buffer *buf, int start, int end,
+                                std::vector<Block> &out) {
+  while (start < end) {
+    int e = start + block_size;
+    if (e >= end - block_size / 2) {
+      e = end;
+    } else {
+      e = buf->line_end(e);
+      e = e < end ? e + 1 : end;
+    }
+    Block b = { e - start, -1, false };
+    out.push_back(b);
+    start = e;
+  }
+}
+
+
+void Fl_Text_Wrap_Cache::update_starts_() {
+  if (starts_valid_) return;
+  starts_.resize(blocks_.size());
+  int pos = 0;
+  for (size_t i = 0; i < blocks_.size(); i++) {
+    starts_[i] = pos;
+    pos += blocks_[i].bytes;
+  }
+  starts_valid_ = true;
+}
+
+
+void Fl_Text_Wrap_Cache::build(const Fl_Text_Buffer *buf) {
+  clear();
+  chunk_(buf, 0, buf->length(), blocks_);
+}
+
+
+void Fl_Text_Wrap_Cache::layout(int margin, Fl_Font font, Fl_Fontsize size,
+                                const void *styles, int nstyles) {
+  if (margin == margin_ && font == font_ && size == size_ &&
+      styles == styles_ && nstyles == nstyles_)
+    return;
+  margin_ = margin;
+  font_ = font;
+  size_ = size;
+  styles_ = styles;
+  nstyles_ = nstyles;
+  for (size_t i = 0; i < blocks_.size(); i++)
+    blocks_[i].lines = -1;
+}
+
+
+void Fl_Text_Wrap_Cache::invalidate(int start, int end) {
+  if (!built())
+    return;
+  for (int i = find(start), j = find(end); i <= j; i++)
+    blocks_[i].lines = -1;
+}
+
+
+int Fl_Text_Wrap_Cache::find(int pos) {
+  update_starts_();
+  int i = int(std::upper_bound(starts_.begin(), starts_.end(), pos) - starts_.begin()) - 1;
+  return i < 0 ? 0 : i;
+}
+
+
+/*
+ The blocks that contain the modified text are replaced by new blocks for
+ the same (now modified) range of text. Very small blocks are merged with
+ a neighbor, so that deleting text does not leave lots of tiny blocks.
+ */
+void Fl_Text_Wrap_Cache::modified(const Fl_Text_Buffer *buf, int pos,
+                                  int nInserted, int nDeleted) {
+  if (!built() || (nInserted == 0 && nDeleted == 0))
+    return;
+  int i = find(pos), j = find(pos + nDeleted);
+  if (i == 0 && j == blocks() - 1) {   // everything changed, rebuild later
+    clear();
+    return;
+  }
+  int s = start(i), e = end(j) + nInserted - nDeleted;
+  if (e - s < block_size / 2 && i > 0)
+    s = start(--i);
+  if (e - s < block_size / 2 && j < blocks() - 1)
+    e += bytes(++j);
+  std::vector<Block> nb;
+  chunk_(buf, s, e, nb);
+  blocks_.erase(blocks_.begin() + i, blocks_.begin() + j + 1);
+  blocks_.insert(blocks_.begin() + i, nb.begin(), nb.end());
+  starts_valid_ = false;
+}
@@ -2,7 +2,7 @@
 // Timeout support functions for the Fast Light Tool Kit (FLTK).
 //
 // Author: Albrecht Schlosser
-// Copyright 2021-2024 by Bill Spitzak and others.
+// Copyright 2021-2026 by Bill Spitzak and others.
 //
 // This library is free software. Distribution and use rights are outlined in
 // the file "COPYING" which should have been included with this file.  If this
@@ -21,8 +21,12 @@
 #include "Fl_System_Driver.H"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h> // for trunc()
 
+#include <algorithm>
+#include <unordered_map>
+
 #if !HAVE_TRUNC
 static inline double trunc(double x) { return x >= 0 ? floor(x) : ceil(x); }
 #endif // !HAVE_TRUNC
@@ -34,8 +38,34 @@ static inline double trunc(double x) { return x >= 0 ? floor(x) : ceil(x); }
 // static class variables
 
 Fl_Timeout *Fl_Timeout::free_timeout = 0;
-Fl_Timeout *Fl_Timeout::first_timeout = 0;
 Fl_Timeout *Fl_Timeout::current_timeout = 0;
+Fl_Timeout::Heap Fl_Timeout::active_timeouts = { 0, 0, 0 };
+Fl_Timeout::Heap Fl_Timeout::new_timeouts = { 0, 0, 0 };
+double Fl_Timeout::clock = 0.0;
+unsigned long Fl_Timeout::serial_counter = 0;
+
+// Active timers with the same callback and data are linked through
+// Fl_Timeout::same_next and same_prev. This map finds the first of them.
+
+namespace {
+
+struct Timeout_Key {
+  Fl_Timeout_Handler cb;
+  void *data;
+  bool operator==(const Timeout_Key &k) const { return cb == k.cb && data == k.data; }
+};
+
+struct Timeout_Key_Hash {
+  size_t operator()(const Timeout_Key &k) const {
+    return std::hash<void*>()((void*)k.cb) ^ (std::hash<void*>()(k.data) * 31);
+  }
+};
+
+typedef std::unordered_map<Timeout_Key, Fl_Timeout*, Timeout_Key_Hash> Timeout_Map;
+
+} // namespace
+
+static Timeout_Map *same_timeouts = 0;
 
 #if FL_TIMEOUT_DEBUG
 static int num_timers = 0;    // DEBUG
@@ -186,18 +216,113 @@ static double elapsed_time() {
 }
 
 /**
-  Insert this timer entry into the active timer queue.
+  Add a timer to the heap.
+*/
+void Fl_Timeout::Heap::push(Fl_Timeout *timer) {
+  if (n == alloc) {
+    alloc = alloc ? alloc * 2 : 32;
+    t = (Fl_Timeout **)realloc(t, alloc * sizeof(Fl_Timeout *));
+  }
+  t[n] = timer;
+  timer->heap = this;
+  timer->index = n++;
+  sift_up(n - 1);
+}
+
+/**
+  Remove a timer from the heap.
+*/
+void Fl_Timeout::Heap::remove(Fl_Timeout *timer) {
+  int i = timer->index;
+  timer->heap = 0;
+  if (i != --n) {
+    t[i] = t[n];
+    t[i]->index = i;
+    sift_up(i);
+    sift_down(t[i]->index);
+  }
+}
+
+void Fl_Timeout::Heap::sift_up(int i) {
+  Fl_Timeout *x = t[i];
+  while (i > 0) {
+    int p = (i - 1) / 2;
+    if (!x->before(t[p])) break;
+    t[i] = t[p];
+    t[i]->index = i;
+    i = p;
+  }
+  t[i] = x;
+  x->index = i;
+}
+
+void Fl_Timeout::Heap::sift_down(int i) {
+  Fl_Timeout *x = t[i];
+  for (;;) {
+    int c = 2 * i + 1;
+    if (c >= n) break;
+    if (c + 1 < n && t[c + 1]->before(t[c])) c++;
+    if (!t[c]->before(x)) break;
+    t[i] = t[c];
+    t[i]->index = i;
+    i = c;
+  }
+  t[i] = x;
+  x->index = i;
+}
+
+/**
+  Insert this timer entry into the queue of new timers.
 
-  The timer is inserted at the required position so the timer queue
-  is always ordered by due time.
+  The timer becomes active when do_timeouts() is called the next time,
+  see Fl_Timeout::new_timeouts.
 */
 void Fl_Timeout::insert() {
-  Fl_Timeout **p = (Fl_Timeout **)&first_timeout;
-  while (*p && (*p)->time <= time) {
-    p = (Fl_Timeout **)&((*p)->next);
+  serial = serial_counter++;
+  new_timeouts.push(this);
+  if (!same_timeouts)
+    same_timeouts = new Timeout_Map;
+  Timeout_Key key = { callback, data };
+  Fl_Timeout *&first = (*same_timeouts)[key];
+  same_prev = 0;
+  same_next = first;
+  if (first)
+    first->same_prev = this;
+  first = this;
+}
+
+/**
+  Remove this timer entry from the active or new timer queue.
+
+  The caller is responsible for adding it to another list.
+*/
+void Fl_Timeout::remove() {
+  if (!heap) return;
+  heap->remove(this);
+  if (same_next)
+    same_next->same_prev = same_prev;
+  if (same_prev) {
+    same_prev->same_next = same_next;
+  } else {
+    Timeout_Key key = { callback, data };
+    if (same_next)
+      (*same_timeouts)[key] = same_next;
+    else
+      same_timeouts->erase(key);
   }
-  next = *p;
-  *p = this;
+  same_next = same_prev = 0;
+}
+
+/**
+  Return the first timer entry in the active or new timer queue with the
+  given callback and data, or NULL if there is none. This is not
+  necessarily the timer that expires first.
+*/
+Fl_Timeout *Fl_Timeout::find(Fl_Timeout_Handler cb, void *data) {
+  if (!same_timeouts) return 0;
+  Timeout_Key key = { cb, data };
+  Timeout_Map::iterator it = same_timeouts->find(key);
+  return it == same_timeouts->end() ? 0 : it->second;
 }
 
 /**
@@ -217,11 +342,7 @@ void Fl_Timeout::insert() {
   \see Fl::has_timeout(Fl_Timeout_Handler cb, void *data)
 */
 int Fl_Timeout::has_timeout(Fl_Timeout_Handler cb, void *data) {
-  for (Fl_Timeout *t = first_timeout; t; t = t->next) {
-    if (t->callback == cb && t->data == data)
-      return 1;
-  }
-  return 0;
+  return find(cb, data) ? 1 : 0;
 }
 
 /**
@@ -266,9 +387,9 @@ void Fl_Timeout::repeat_timeout(double time, Fl_Timeout_Handler cb, void *data)
   Fl_Timeout *t = (Fl_Timeout *)get(time, cb, data);
   Fl_Timeout *cur = current_timeout;
   if (cur) {
-    t->time += cur->time;   // was: missed_timeout_by (always <= 0.0)
-    if (t->time < 0.0)
-      t->time = 0.001;      // at least 1 ms
+    t->time += cur->delay();  // was: missed_timeout_by (always <= 0.0)
+    if (t->delay() < 0.0)
+      t->delay(0.001);        // at least 1 ms
   }
   t->insert();
 }
@@ -289,15 +410,29 @@ void Fl_Timeout::repeat_timeout(double time, Fl_Timeout_Handler cb, void *data)
   \see Fl::remove_timeout(Fl_Timeout_Handler cb, void *data)
 */
 void Fl_Timeout::remove_timeout(Fl_Timeout_Handler cb, void *data) {
-  for (Fl_Timeout** p = &first_timeout; *p;) {
-    Fl_Timeout* t = *p;
-    if (t->callback == cb && (t->data == data || !data)) {
-      *p = t->next;
+  Fl_Timeout *t;
+  if (data) {
+    while ((t = find(cb, data))) {
+      t->remove();
       t->next = free_timeout;
       free_timeout = t;
-    } else {
-      p = &(t->next);
     }
+    return;
+  }
+  // wildcard: collect all matching timers before the heaps are modified
+  std::vector<Fl_Timeout *> matches;
+  Heap *heaps[2] = { &active_timeouts, &new_timeouts };
+  for (int h = 0; h < 2; h++) {
+    for (int i = 0; i < heaps[h]->n; i++) {
+      if (heaps[h]->t[i]->callback == cb)
+        matches.push_back(heaps[h]->t[i]);
+    }
+  }
+  for (size_t i = 0; i < matches.size(); i++) {
+    t = matches[i];
+    t->remove();
+    t->next = free_timeout;
+    free_timeout = t;
   }
 }
 
@@ -323,34 +458,50 @@ void Fl_Timeout::remove_timeout(Fl_Timeout_Handler cb, void *data) {
 */
 int Fl_Timeout::remove_next_timeout(Fl_Timeout_Handler cb, void *data, void **data_return) {
   int ret = 0;
-  for (Fl_Timeout** p = &first_timeout; *p;) { // scan all timeouts
-    Fl_Timeout* t = *p;
-    if (t->callback == cb && (t->data == data || !data)) { // timeout matches
+  Fl_Timeout *first = 0;  // the matching timeout that expires first
+  if (data) {
+    for (Fl_Timeout *t = find(cb, data); t; t = t->same_next) {
       ret++;
-      if (ret == 1) { // first timeout: remove
-        if (data_return)
-          *data_return = t->data;
-        *p = t->next;
-        t->next = free_timeout;
-        free_timeout = t;
-        continue;
+      if (!first || t->before(first))
+        first = t;
+    }
+  } else {
+    Heap *heaps[2] = { &active_timeouts, &new_timeouts };
+    for (int h = 0; h < 2; h++) {
+      for (int i = 0; i < heaps[h]->n; i++) {
+        Fl_Timeout *t = heaps[h]->t[i];
+        if (t->callback == cb) {
+          ret++;
+          if (!first || t->before(first))
+            first = t;
+        }
       }
-      p = &(t->next);
-    } // timeout matches
-    else { // no match
-      p = &(t->next);
     }
-  } // scan all timeouts
+  }
+  if (first) {
+    if (data_return)
+      *data_return = first->data;
+    first->remove();
+    first->next = free_timeout;
+    free_timeout = first;
+  }
   return ret;
 }
 
+static bool timeout_before(const Fl::TimeoutData &a, const Fl::TimeoutData &b) {
+  return a.t < b.t;
+}
+
 std::vector<Fl::TimeoutData> Fl_Timeout::timeout_list() {
   std::vector<Fl::TimeoutData> v;
-  const Fl_Timeout *t = first_timeout;
-  while (t) {
-    v.push_back( { t->time, t->callback, t->data } );
-    t = t->next;
+  Heap *heaps[2] = { &active_timeouts, &new_timeouts };
+  for (int h = 0; h < 2; h++) {
+    for (int i = 0; i < heaps[h]->n; i++) {
+      Fl_Timeout *t = heaps[h]->t[i];
+      v.push_back( { t->delay(), t->callback, t->data } );
+    }
   }
+  std::stable_sort(v.begin(), v.end(), timeout_before);
   return v;
 }
 
@@ -367,18 +518,10 @@ std::vector<Fl::TimeoutData> Fl_Timeout::timeout_list() {
 void Fl_Timeout::make_current() {
   // printf("[%4d] Fl_Timeout::make_current(%p)\n", __LINE__, this);
   // remove the timer entry from the active timer queue
-  for (Fl_Timeout** p = &first_timeout; *p;) {
-    Fl_Timeout* t = *p;
-    if (t == this) {
-      *p = t->next;
-      // push it to the current timer stack
-      t->next = current_timeout;
-      current_timeout = t;
-      break;
-    } else {
-      p = &(t->next);
-    }
-  }
+  remove();
+  // push it to the current timer stack
+  next = current_timeout;
+  current_timeout = this;
 }
 
 /**
@@ -434,7 +577,8 @@ Fl_Timeout *Fl_Timeout::current() {
   The timer object will be initialized with the input parameters
   as given by Fl::add_timeout() or Fl::repeat_timeout().
 
-  Fl_Timeout objects are maintained in three queues:
+  Fl_Timeout objects are maintained in four queues:
+  - new timer queue
   - active timer queue
   - list (stack, i.e. LIFO) of currently executing timer callbacks
   - free timer entries.
@@ -444,8 +588,9 @@ Fl_Timeout *Fl_Timeout::current() {
   object is either found in the queue of free timer entries or a new
   timer object is created (operator new).
 
-  Active timer entries are inserted into the "active timer queue" until
-  they expire and their callback is called.
+  New timer entries are inserted into the "new timer queue" and moved
+  to the "active timer queue" by the next do_timeouts() call. They stay
+  there until they expire and their callback is called.
 
   Before the callback is called the timer entry is inserted into the list
   of current timers, i.e. it becomes the Fl_Timeout::current() timeout.
@@ -482,7 +627,6 @@ Fl_Timeout *Fl_Timeout::get(double time, Fl_Timeout_Handler cb, void *data) {
   }
 
   t->next = 0;
-  t->skip = 1;          // see do_timeouts() (issue #450)
   t->delay(time);
   t->callback = cb;
   t->data = data;
@@ -498,26 +642,17 @@ Fl_Timeout *Fl_Timeout::get(double time, Fl_Timeout_Handler cb, void *data) {
   This must be called before new timers are added to the timer queue to make
   sure that the next timer decrement does not count down too much time.
 
+  The timers store their due time, hence this only advances
+  Fl_Timeout::clock, which takes constant time.
+
   \see Fl_Timeout::do_timeouts()
 */
 void Fl_Timeout::elapse_timeouts() {
   double elapsed = elapsed_time();
   // printf("elapse_timeouts: elapsed = %9.6f\n", double(elapsed)/1000000.);
 
-  if (elapsed > 0.0) {
-
-    // active timers
-
-    for (Fl_Timeout* t = first_timeout; t; t = t->next) {
-      t->time -= elapsed;
-    }
-
-    // "current" timers, i.e. timers being serviced
-
-    for (Fl_Timeout* t = current_timeout; t; t = t->next) {
-      t->time -= elapsed;
-    }
-  }
+  if (elapsed > 0.0)
+    clock += elapsed;
 }
 
 /**
@@ -525,24 +660,20 @@ void Fl_Timeout::elapse_timeouts() {
 */
 void Fl_Timeout::do_timeouts() {
 
-  // Reset "skip" flag for existing timers (issue #450).
-  // For timers inserted in timer callbacks 'skip' will be true (1)
+  // Activate the timers that were added since the last call (issue #450).
+  // Timers added by the callbacks below stay in the "new" queue and are
+  // not called before the next call, even if they are expired.
 
-  Fl_Timeout *t = first_timeout;
-  while (t) {
-    t->skip = 0;
-    t = t->next;
+  Fl_Timeout *t;
+  while ((t = new_timeouts.top())) {
+    new_timeouts.remove(t);
+    active_timeouts.push(t);
   }
 
-  if (first_timeout) {
+  if (active_timeouts.top()) {
     Fl_Timeout::elapse_timeouts();
-    while ((t = first_timeout)) {
-      if (t->time > 0) break;
-
-      // skip timers inserted during timeout handling (issue #450)
-      while (t && t->skip)
-        t = t->next;
-      if (!t || t->time > 0) break;
+    while ((t = active_timeouts.top())) {
+      if (t->delay() > 0) break;
 
       // make this timeout the "current" timeout
       t->make_current();
@@ -580,10 +711,13 @@ void Fl_Timeout::do_timeouts() {
   \return  delay until next timeout or 0.0 (see description)
 */
 double Fl_Timeout::time_to_wait(double ttw) {
-  Fl_Timeout *t = first_timeout;
+  Fl_Timeout *t = active_timeouts.top();
+  Fl_Timeout *n = new_timeouts.top();
+  if (!t || (n && n->before(t)))
+    t = n;
   if (!t) return ttw;
   double tdelay = t->delay();
-if (tdelay < 0.0)
+  if (tdelay < 0.0)
     return 0.0;
   if (tdelay < ttw)
     return tdelay;
@@ -599,15 +733,10 @@ void Fl_Timeout::debug(int level) {
 
   printf("\nFl_Timeout::debug: number of allocated timers = %d\n", num_timers);
 
-  int active = 0;
-  Fl_Timeout *t = first_timeout;
-  while (t) {
-    active++;
-    t = t->next;
-  }
+  int active = active_timeouts.n + new_timeouts.n;
 
   int current = 0;
-  t = current_timeout;
+  Fl_Timeout *t = current_timeout;
   while (t) {
     current++;
     t = t->next;
@@ -622,12 +751,9 @@ void Fl_Timeout::debug(int level) {
 
   printf("Fl_Timeout::debug: active: %d, current: %d, free: %d\n\n", active, current, free);
 
-  t = first_timeout;
-  int n = 0;
-  while (t) {
-    printf("Active timer %3d: time = %10.6f sec\n", n+1, t->delay());
-    t = t->next;
-    n++;
+  std::vector<Fl::TimeoutData> v = timeout_list();
+  for (size_t n = 0; n < v.size(); n++) {
+    printf("Active timer %3d: time = %10.6f sec\n", int(n+1), v[n].t);
   }
 } // Fl_Timeout::debug(int)
 
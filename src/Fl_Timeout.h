@@ -2,7 +2,7 @@
 // Header for timeout support functions for the Fast Light Tool Kit (FLTK).
 //
 // Author: Albrecht Schlosser
-// Copyright 2021-2024 by Bill Spitzak and others.
+// Copyright 2021-2026 by Bill Spitzak and others.
 //
 // This library is free software. Distribution and use rights are outlined in
 // the file "COPYING" which should have been included with this file.  If this
@@ -57,11 +57,33 @@ class Fl_Timeout {
 
 protected:
 
-  Fl_Timeout *next;             // ** Link to next timeout
+  /*
+    A binary min-heap of timers, ordered by due time. Timers with the same
+    due time are ordered by the time they were added. Every timer knows its
+    heap and its index in the heap, so it can be removed in O(log n) time.
+    All members are zero initialized because the heaps are static.
+  */
+  struct Heap {
+    Fl_Timeout **t;             // array of timers
+    int n;                      // number of timers in the heap
+    int alloc;                  // allocated size of the array
+    void push(Fl_Timeout *timer);
+    void remove(Fl_Timeout *timer);
+    Fl_Timeout *top() const { return n ? t[0] : 0; }
+  private:
+    void sift_up(int i);
+    void sift_down(int i);
+  };
+
+  Fl_Timeout *next;             // ** Link to next timeout (current or free)
   Fl_Timeout_Handler callback;  // the user's callback
   void *data;                   // the user's callback data
-  double time;                  // delay until timeout
-  int skip;                     // skip "new" (inserted) timers (issue #450)
+  double time;                  // due time, see Fl_Timeout::clock
+  unsigned long serial;         // insertion order for timers with equal time
+  Heap *heap;                   // active_timeouts, new_timeouts, or NULL
+  int index;                    // index in heap
+  Fl_Timeout *same_next;        // timers with the same callback and data
+  Fl_Timeout *same_prev;
 
   // constructor
   Fl_Timeout() {
@@ -69,18 +91,29 @@ protected:
     callback = 0;
     data = 0;
     time = 0;
-    skip = 0;
+    serial = 0;
+    heap = 0;
+    index = 0;
+    same_next = same_prev = 0;
   }
 
   // destructor
   ~Fl_Timeout() {}
 
+  // compare the due time of two timers
+  bool before(const Fl_Timeout *t) const {
+    return time < t->time || (time == t->time && serial < t->serial);
+  }
+
   // get a new timer entry from the pool or allocate a new one
   static Fl_Timeout *get(double time, Fl_Timeout_Handler cb, void *data);
 
-  // insert this timer into the active timer queue, sorted by expiration time
+  // insert this timer into the queue of new timers
   void insert();
 
+  // remove this timer from its queue and add it to the list of free timers
+  void remove();
+
   // remove this timer from the active timer queue and
   // add it to the "current" timer stack
   void make_current();
@@ -89,14 +122,17 @@ protected:
   // add it to the list of free timers
   void release();
 
+  // find the first active timer with this callback and data
+  static Fl_Timeout *find(Fl_Timeout_Handler cb, void *data);
+
   /** Get the timer's delay in seconds. */
   double delay() {
-    return time;
+    return time - clock;
   }
 
   /** Set the timer's delay in seconds. */
   void delay(double t) {
-    time = t;
+    time = clock + t;
   }
 
 public:
@@ -131,15 +167,38 @@ protected:
   static Fl_Timeout *current();
 
   /**
-    List of active timeouts.
+    Queue of active timeouts.
 
     These timeouts can be triggered when due, which calls their callbacks.
     The lifetime of a timeout:
+    - new, in queue \p new_timeouts
     - active, in this queue
     - callback running, in queue \p current_timeout
     - done, in list of free timeouts, ready to be reused.
   */
-  static Fl_Timeout *first_timeout;
+  static Heap active_timeouts;
+
+  /**
+    Queue of timeouts added since do_timeouts() was called last.
+
+    These timeouts are not triggered by the running do_timeouts() call even
+    if they are due (issue #450). The next do_timeouts() call moves them
+    to \p active_timeouts.
+  */
+  static Heap new_timeouts;
+
+  /**
+    The time in seconds since the first timeout was added.
+
+    elapse_timeouts() advances the clock, which elapses all timers at once,
+    because the timers store their due time rather than their delay.
+  */
+  static double clock;
+
+  /**
+    Counter used to order timers with the same due time.
+  */
+  static unsigned long serial_counter;
 
   /**
     List of free timeouts after use.
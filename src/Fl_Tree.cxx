@@ -83,6 +83,8 @@ Fl_Tree::Fl_Tree(int X, int Y, int W, int H, const char *L) : Fl_Group(X,Y,W,H,L
   _lastselect           = nullptr;
   _lastpushed           = 0;
   _auto_resize_children = 0;                    // don't resize children automatically
+  _layout_gen           = 1;
+  _position_gen         = 1;
 
   box(FL_DOWN_BOX);
   color(FL_BACKGROUND2_COLOR, FL_SELECTION_COLOR);
@@ -327,6 +329,7 @@ int Fl_Tree::handle(int e) {
               set_item_focus(next_visible_item(_item_focus, ekey));     // next item up|dn
               if ( _item_focus ) {                                      // item in focus?
                 // Autoscroll
+                _item_focus->update_position();         // may have been skipped by draw()
                 int itemtop = _item_focus->y();
                 int itembot = _item_focus->y()+_item_focus->h();
                 if ( itemtop < y() ) { show_item_top(_item_focus); }
@@ -648,9 +651,13 @@ void Fl_Tree::calc_dimensions() {
 /// The tree hierarchy's size only changes when items are added/removed,
 /// open/closed, label contents or font sizes changed, margins changed, etc.
 ///
-/// This calculation involves walking the *entire* tree from top to bottom,
+/// The height and width of every item and its open children are cached,
+/// so only items that changed since the last calculation (and their
+/// parents) are measured again. Items with widgets are always measured.
+/// Fl_Tree::recalc_tree() discards the cached sizes of all items, and
+/// calculating them involves walking the *entire* tree from top to bottom,
 /// potentially a slow calculation if the tree has many items (potentially
-/// hundreds of thousands), and should therefore be called sparingly.
+/// hundreds of thousands).
 ///
 /// For this reason, recalc_tree() is used as a way to /schedule/
 /// calculation when changes affect the tree hierarchy's size.
@@ -677,14 +684,39 @@ void Fl_Tree::calc_tree() {
     X -= _prefs.openicon_w();
     W += _prefs.openicon_w();
   }
-  int xmax = 0, render = 0, ytop = Y;
+  int ytop = Y;
   fl_font(_prefs.labelfont(), _prefs.labelsize());
-  _root->draw(X, Y, W, 0, xmax, 1, render);             // descend into tree without drawing (render=0)
+  _root->calc_layout(X, Y, W, 1);                       // measure items whose size is not cached
   // Save computed tree width and height
-  _tree_w = _prefs.marginleft() + xmax - X;             // include margin in tree's width
+  _tree_w = _prefs.marginleft() + _root->_layout_w;     // include margin in tree's width
   _tree_h = _prefs.margintop()  + Y - ytop;             // include margin in tree's height
   // Calc tree dims again; now that tree_w/tree_h are known, scrollbars are calculated.
   calc_dimensions();
+  // Items whose size was cached were not laid out
+  calc_positions();
+}
+
+// Position and width of the root item for the current scroll position
+void Fl_Tree::item_origin(int &X, int &Y, int &W) const {
+  X = _tix + _prefs.marginleft() - (int)_hscroll->value();
+  Y = _tiy + _prefs.margintop()  - (int)_vscroll->value();
+  W = _tiw - X + _tix;
+  // Adjust root's X/W if connectors off
+  if (_prefs.connectorstyle() == FL_TREE_CONNECTOR_NONE) {
+    X -= _prefs.openicon_w();
+    W += _prefs.openicon_w();
+  }
+}
+
+// Lay out the items on screen without drawing them, so that their
+// xywh are current for find_clicked() and displayed() before the next draw()
+void Fl_Tree::calc_positions() {
+  if ( !_root ) return;
+  int X, Y, W, xmax = 0;
+  item_origin(X, Y, W);
+  _position_gen++;
+  fl_font(_prefs.labelfont(), _prefs.labelsize());
+  _root->draw_r(X, Y, W, 0, xmax, 1, 0, 1);
 }
 
 void Fl_Tree::resize(int X,int Y,int W, int H) {
@@ -715,18 +747,13 @@ void Fl_Tree::draw() {
     if ( ! _root ) return;
     // These values are changed during drawing
     // By end, 'Y' will be the lowest point on the tree
-    int X = _tix + _prefs.marginleft() - _hscroll->value();
-    int Y = _tiy + _prefs.margintop()  - _vscroll->value();
-    int W = _tiw - X + _tix;
-    // Adjust root's X/W if connectors off
-    if (_prefs.connectorstyle() == FL_TREE_CONNECTOR_NONE) {
-      X -= _prefs.openicon_w();
-      W += _prefs.openicon_w();
-    }
+    int X, Y, W;
+    item_origin(X, Y, W);
     // Draw entire tree, starting with root
     fl_push_clip(_tix,_tiy,_tiw,_tih);
     {
       int xmax = 0;
+      _position_gen++;
       fl_font(_prefs.labelfont(), _prefs.labelsize());
       _root->draw(X, Y, W,                              // descend into tree here to draw it
                   (Fl::focus()==this)?_item_focus:0,    // show focus item ONLY if Fl_Tree has focus
@@ -2335,6 +2362,7 @@ Fl_Tree_Item_Draw_Mode Fl_Tree::item_draw_mode() const {
 ///
 void Fl_Tree::item_draw_mode(Fl_Tree_Item_Draw_Mode mode) {
   _prefs.item_draw_mode(mode);
+  recalc_tree();
 }
 
 /// Set the 'item draw mode' used for the tree to integer \p 'mode'.
@@ -2346,6 +2374,7 @@ void Fl_Tree::item_draw_mode(Fl_Tree_Item_Draw_Mode mode) {
 ///
 void Fl_Tree::item_draw_mode(int mode) {
   _prefs.item_draw_mode(Fl_Tree_Item_Draw_Mode(mode));
+  recalc_tree();
 }
 
 /// See if \p 'item' is currently displayed on-screen (visible within the widget).
@@ -2361,6 +2390,8 @@ void Fl_Tree::item_draw_mode(int mode) {
 int Fl_Tree::displayed(Fl_Tree_Item *item) {
   item = item ? item : first();
   if (!item) return(0);
+  if ( _tree_w == -1 ) calc_tree();
+  item->update_position();                      // may not be on screen
   return( (item->y() >= y()) && (item->y() <= (y()+h()-item->h())) ? 1 : 0);
 }
 
@@ -2381,10 +2412,13 @@ int Fl_Tree::displayed(Fl_Tree_Item *item) {
 void Fl_Tree::show_item(Fl_Tree_Item *item, int yoff) {
   item = item ? item : first();
   if (!item) return;
+  if ( _tree_w == -1 ) calc_tree();
+  item->update_position();                      // may have been skipped by draw()
   int newval = item->y() - y() - yoff + (int)_vscroll->value();
   if ( newval < _vscroll->minimum() ) newval = (int)_vscroll->minimum();
   if ( newval > _vscroll->maximum() ) newval = (int)_vscroll->maximum();
   _vscroll->value(newval);
+  calc_positions();                             // items on screen changed
   redraw();
 }
 
@@ -2686,8 +2720,15 @@ void Fl_Tree::fix_scrollbar_order() {
 }
 
 /// Schedule tree to recalc the entire tree size.
+///
+/// This discards the cached sizes of all items. Changes made through the
+/// Fl_Tree_Item API only recalculate the items concerned, but apps should
+/// call this if the content of custom items (see Fl_Tree_Item::draw_item_content())
+/// changes its size.
+///
 /// \note Must be using FLTK ABI 1.3.3 or higher for this to be effective.
 ///
 void Fl_Tree::recalc_tree() {
   _tree_w = _tree_h = -1;
+  _layout_gen++;                // discard the cached sizes of all items
 }
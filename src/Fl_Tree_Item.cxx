@@ -72,6 +72,11 @@ void Fl_Tree_Item::_Init(const Fl_Tree_Prefs &prefs, Fl_Tree *tree) {
   _children.manage_item_destroy(1);     // let array's dtor manage destroying Fl_Tree_Items
   _prev_sibling     = 0;
   _next_sibling     = 0;
+  _layout_h         = 0;
+  _layout_w         = 0;
+  _layout_gen       = 0;                // not cached yet
+  _layout_widgets   = 0;
+  _position_gen     = 0;
 }
 
 /// Constructor.
@@ -131,6 +136,11 @@ Fl_Tree_Item::Fl_Tree_Item(const Fl_Tree_Item *o) {
   _parent           = o->_parent;
   _prev_sibling     = 0;                // do not copy ptrs! use update_prev_next()
   _next_sibling     = 0;                // do not copy ptrs! use update_prev_next()
+  _layout_h         = 0;
+  _layout_w         = 0;
+  _layout_gen       = 0;                // not cached yet
+  _layout_widgets   = 0;
+  _position_gen     = 0;
 }
 
 /// Print the tree as 'ascii art' to stdout.
@@ -157,8 +167,10 @@ void Fl_Tree_Item::show_self(const char *indent) const {
 /// Makes and manages an internal copy of \p 'name'.
 ///
 void Fl_Tree_Item::label(const char *name) {
-  if ( _label ) { free((void*)_label); _label = 0; }
+  const char *old = _label;
   _label = name ? fl_strdup(name) : 0;
+  if ( _parent ) _parent->_children.relabel(this, old);  // keep parent's label index current
+  if ( old ) free((void*)old);
   recalc_tree();                // may change label geometry
 }
 
@@ -185,13 +197,8 @@ void Fl_Tree_Item::clear_children() {
 /// \version 1.3.0 release
 ///
 int Fl_Tree_Item::find_child(const char *name) {
-  if ( name ) {
-    for ( int t=0; t<children(); t++ )
-      if ( child(t)->label() )
-        if ( strcmp(child(t)->label(), name) == 0 )
-          return(t);
-  }
-  return(-1);
+  Fl_Tree_Item *item = _children.find_label(name);
+  return(item ? find_child(item) : -1);
 }
 
 /// Return the /immediate/ child of current item
@@ -201,12 +208,7 @@ int Fl_Tree_Item::find_child(const char *name) {
 /// \version 1.3.3
 ///
 const Fl_Tree_Item* Fl_Tree_Item::find_child_item(const char *name) const {
-  if ( name )
-    for ( int t=0; t<children(); t++ )
-      if ( child(t)->label() )
-        if ( strcmp(child(t)->label(), name) == 0 )
-          return(child(t));
-  return(0);
+  return(_children.find_label(name));
 }
 
 /// Non-const version of Fl_Tree_Item::find_child_item(const char *name) const.
@@ -224,18 +226,11 @@ Fl_Tree_Item* Fl_Tree_Item::find_child_item(const char *name) {
 /// \version 1.3.0 release
 ///
 const Fl_Tree_Item *Fl_Tree_Item::find_child_item(char **arr) const {
-  for ( int t=0; t<children(); t++ ) {
-    if ( child(t)->label() ) {
-      if ( strcmp(child(t)->label(), *arr) == 0 ) {     // match?
-        if ( *(arr+1) ) {                               // more in arr? descend
-          return(_children[t]->find_child_item(arr+1));
-        } else {                                        // end of arr? done
-          return(_children[t]);
-        }
-      }
-    }
+  const Fl_Tree_Item *item = _children.find_label(*arr);
+  if ( item && *(arr+1) ) {                             // more in arr? descend
+    return(item->find_child_item(arr+1));
   }
-  return(0);
+  return(item);                                         // end of arr? done
 }
 
 /// Non-const version of Fl_Tree_Item::find_child_item(char **arr) const.
@@ -315,6 +310,11 @@ Fl_Tree_Item *Fl_Tree_Item::add(const Fl_Tree_Prefs &prefs,
       return(item);
     }
     case FL_TREE_SORT_ASCENDING: {
+      int pos = _children.sorted_position(new_label, 1);
+      if ( pos >= 0 ) {         // binary search in large sorted arrays
+        _children.insert(pos, item);
+        return(item);
+      }
       for ( int t=0; t<_children.total(); t++ ) {
         Fl_Tree_Item *c = _children[t];
         if ( c->label() && strcmp(c->label(), new_label) > 0 ) {
@@ -326,6 +326,11 @@ Fl_Tree_Item *Fl_Tree_Item::add(const Fl_Tree_Prefs &prefs,
       return(item);
     }
     case FL_TREE_SORT_DESCENDING: {
+      int pos = _children.sorted_position(new_label, -1);
+      if ( pos >= 0 ) {         // binary search in large sorted arrays
+        _children.insert(pos, item);
+        return(item);
+      }
       for ( int t=0; t<_children.total(); t++ ) {
         Fl_Tree_Item *c = _children[t];
         if ( c->label() && strcmp(c->label(), new_label) < 0 ) {
@@ -442,6 +447,7 @@ Fl_Tree_Item *Fl_Tree_Item::insert_above(const Fl_Tree_Prefs &prefs, const char
 Fl_Tree_Item* Fl_Tree_Item::deparent(int pos) {
   Fl_Tree_Item *orphan = _children[pos];
   if ( _children.deparent(pos) < 0 ) return NULL;
+  recalc_tree();                // may change tree geometry
   return orphan;
 }
 
@@ -457,6 +463,7 @@ int Fl_Tree_Item::reparent(Fl_Tree_Item *newchild, int pos) {
   int ret;
   if ( (ret = _children.reparent(newchild, this, pos)) < 0 ) return ret;
   newchild->parent(this);               // take custody
+  recalc_tree();                        // may change tree geometry
   return 0;
 }
 
@@ -661,16 +668,11 @@ int Fl_Tree_Item::remove_child(Fl_Tree_Item *item) {
 /// \version 1.3.3
 ///
 int Fl_Tree_Item::remove_child(const char *name) {
-  for ( int t=0; t<children(); t++ ) {
-    if ( child(t)->label() ) {
-      if ( strcmp(child(t)->label(), name) == 0 ) {
-        _children.remove(t);
-        recalc_tree();          // may change tree geometry
-        return(0);
-      }
-    }
-  }
-  return(-1);
+  int t = find_child(name);
+  if ( t < 0 ) return(-1);
+  _children.remove(t);
+  recalc_tree();                // may change tree geometry
+  return(0);
 }
 
 /// Swap two of our children, given two child index values \p 'ax' and \p 'bx'.
@@ -771,6 +773,7 @@ void Fl_Tree_Item::draw_vertical_connector(int x, int y1, int y2, const Fl_Tree_
 ///
 const Fl_Tree_Item *Fl_Tree_Item::find_clicked(const Fl_Tree_Prefs &prefs, int yonly) const {
   if ( ! is_visible() ) return(0);
+  if ( _position_gen != _tree->_position_gen ) return(0);      // not on screen
   if ( is_root() && !prefs.showroot() ) {
     // skip event check if we're root but root not being shown
   } else {
@@ -972,14 +975,104 @@ int Fl_Tree_Item::draw_item_content(int render) {
 ///                               0: no rendering, just calculate size w/out drawing.
 ///                               1: render item as well as size calc
 ///
+/// When rendering, children whose subtrees lie entirely outside the
+/// tree's visible area (extended by one screenful above and below) are
+/// skipped using the subtree heights cached by Fl_Tree::calc_tree(),
+/// unless they contain widgets. The xywh of skipped items is not updated.
+///
 /// \version 1.3.3 ABI feature: modified parameters
 ///
 void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
                         int &tree_item_xmax, int lastchild, int render) {
+  draw_r(X, Y, W, itemfocus, tree_item_xmax, lastchild, render, render);
+}
+
+/*
+  Implementation of draw(). If skip is set, children outside the visible
+  area are skipped, see draw(). Fl_Tree::calc_positions() uses this with
+  render=0 to lay out the items on screen without drawing them.
+*/
+void Fl_Tree_Item::draw_r(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
+                          int &tree_item_xmax, int lastchild, int render, int skip) {
   Fl_Tree_Prefs &prefs = _tree->_prefs;
   if ( !is_visible() ) return;
   int tree_top = tree()->_tiy;
   int tree_bot = tree_top + tree()->_tih;
+  int item_top = Y;
+  int child_x;
+  int xmax = draw_self(X, Y, W, itemfocus, lastchild, render, child_x);
+  // Manage tree_item_xmax
+  if ( xmax > tree_item_xmax )
+    tree_item_xmax = xmax;
+  // Draw child items (if any)
+  if ( has_children() && is_open() ) {
+    int child_w = W - (child_x-X);
+    int child_y_start = Y;
+    // Range of items to lay out when rendering, see calc_layout()
+    int layout_top = tree_top - tree()->_tih;
+    int layout_bot = tree_bot + tree()->_tih;
+    int gen = tree()->_layout_gen;
+    int cached = (_layout_gen == gen && !_layout_widgets) ? 1 : 0;
+    for ( int t=0; t<children(); t++ ) {
+      Fl_Tree_Item *child = _children[t];
+      if ( skip && Y > layout_bot && cached ) {
+        // All remaining children are below the screen
+        Y = item_top + _layout_h - prefs.openchild_marginbottom();
+        break;
+      }
+      if ( skip && child->_layout_gen == gen && !child->_layout_widgets &&
+           ( Y + child->_layout_h < layout_top || Y > layout_bot ) ) {
+        Y += child->_layout_h;          // skip child's subtree
+        continue;
+      }
+      int is_lastchild = ((t+1)==children()) ? 1 : 0;
+      child->draw_r(child_x, Y, child_w, itemfocus, tree_item_xmax, is_lastchild, render, skip);
+    }
+    Y += prefs.openchild_marginbottom();                // offset below open child tree
+    if ( ! lastchild ) {
+      // Draw vertical connector between this item and the bottom of its children.
+      //
+      //           o Aaa            <- Item we're drawing has >20k children.
+      //   ytop →  :  :.. 0001
+      //           :  :.. 0002
+      //           :  :       } ~20k items
+      //           :  :.. 19998
+      //        ┌──:──:.. 19999 ──┐
+      //        │  :  :.. 20000   │
+      //        │  :  :.. 20001   │ <- visible screen
+      //        │  :  :.. 20002   │    area
+      //        └──:──:.. 20003 ──┘
+      //           :  :.. 20004
+      //           :
+      //   ybot →  :  ← we're drawing this long vertical connector
+      //           :
+      //           o Bbb
+      //
+      int hconn_x = X+prefs.openicon_w()/2-1;
+      int ytop = child_y_start;
+      int ybot = Y;
+      int is_clipped = ((ytop < tree_top) && (ybot < tree_top)) ||   // completely off top of scrn? clip
+                       ((ytop > tree_bot) && (ybot > tree_bot));     // completely off bot of scrn? clip
+      if (render && !is_clipped ) {
+        // Clip vert line to within screen area
+        ytop = (ytop < tree_top) ? tree_top : ytop;
+        ybot = (ybot > tree_bot) ? tree_bot : ybot;
+        draw_vertical_connector(hconn_x, ytop, ybot, prefs);
+      }
+    }
+  }
+}
+
+/*
+  Draw this item without its children, or calculate its geometry if
+  render is 0. Advances Y to the next item and sets child_x to the
+  horizontal position of the children. Returns the item's xmax, or 0.
+*/
+int Fl_Tree_Item::draw_self(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
+                            int lastchild, int render, int &child_x) {
+  Fl_Tree_Prefs &prefs = _tree->_prefs;
+  int tree_top = tree()->_tiy;
+  int tree_bot = tree_top + tree()->_tih;
   int H = calc_item_height(prefs);      // height of item
   int H2 = H + prefs.linespacing();     // height of item with line spacing
 
@@ -988,6 +1081,7 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
   _xywh[1] = Y;
   _xywh[2] = W;
   _xywh[3] = H;
+  _position_gen = tree()->_position_gen;
 
   // Determine collapse icon's xywh
   //   Note: calculate collapse icon's xywh for possible mouse click detection.
@@ -1131,53 +1225,78 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
     }                   // end drawthis
   }                     // end clipped
   if ( drawthis ) Y += H2;                                      // adjust Y (even if clipped)
-  // Manage tree_item_xmax
-  if ( xmax > tree_item_xmax )
-    tree_item_xmax = xmax;
-  // Draw child items (if any)
-  if ( has_children() && is_open() ) {
-    int child_x = drawthis ? (hconn_x_center - (icon_w/2) + 1)  // offset children to right,
-                           : X;                                 // unless didn't drawthis
-    int child_w = W - (child_x-X);
-    int child_y_start = Y;
-    for ( int t=0; t<children(); t++ ) {
-      int is_lastchild = ((t+1)==children()) ? 1 : 0;
-      _children[t]->draw(child_x, Y, child_w, itemfocus, tree_item_xmax, is_lastchild, render);
-    }
+  child_x = drawthis ? (hconn_x_center - (icon_w/2) + 1)      // offset children to right,
+                     : X;                                       // unless didn't drawthis
+  return xmax;
+}
+
+/*
+  Calculate the cached height and width of this item and its open
+  children, see Fl_Tree::calc_tree(). Items are laid out at Y, which is
+  advanced to the next item. Children whose size is already cached are
+  skipped, except if they contain widgets, which are always laid out.
+*/
+void Fl_Tree_Item::calc_layout(int X, int &Y, int W, int lastchild) {
+  int gen = _tree->_layout_gen;
+  if ( _layout_gen == gen && !_layout_widgets ) {
+    Y += _layout_h;
+    return;
+  }
+  int item_top = Y;
+  _layout_w = 0;
+  _layout_widgets = 0;
+  if ( is_visible() ) {
+    int child_x;
+    int xmax = draw_self(X, Y, W, 0, lastchild, 0, child_x);
+    if ( xmax ) _layout_w = xmax - X;
+    if ( widget() ) _layout_widgets = 1;
     if ( has_children() && is_open() ) {
-      Y += prefs.openchild_marginbottom();              // offset below open child tree
-    }
-    if ( ! lastchild ) {
-      // Draw vertical connector between this item and the bottom of its children.
-      //
-      //           o Aaa            <- Item we're drawing has >20k children.
-      //   ytop →  :  :.. 0001
-      //           :  :.. 0002
-      //           :  :       } ~20k items
-      //           :  :.. 19998
-      //        ┌──:──:.. 19999 ──┐
-      //        │  :  :.. 20000   │
-      //        │  :  :.. 20001   │ <- visible screen
-      //        │  :  :.. 20002   │    area
-      //        └──:──:.. 20003 ──┘
-      //           :  :.. 20004
-      //           :
-      //   ybot →  :  ← we're drawing this long vertical connector
-      //           :
-      //           o Bbb
-      //
-      int ytop = child_y_start;
-      int ybot = Y;
-      int is_clipped = ((ytop < tree_top) && (ybot < tree_top)) ||   // completely off top of scrn? clip
-                       ((ytop > tree_bot) && (ybot > tree_bot));     // completely off bot of scrn? clip
-      if (render && !is_clipped ) {
-        // Clip vert line to within screen area
-        ytop = (ytop < tree_top) ? tree_top : ytop;
-        ybot = (ybot > tree_bot) ? tree_bot : ybot;
-        draw_vertical_connector(hconn_x, ytop, ybot, prefs);
+      int child_w = W - (child_x-X);
+      for ( int t=0; t<children(); t++ ) {
+        Fl_Tree_Item *child = _children[t];
+        child->calc_layout(child_x, Y, child_w, (t+1)==children());
+        if ( child->_layout_w && child_x - X + child->_layout_w > _layout_w )
+          _layout_w = child_x - X + child->_layout_w;
+        if ( child->_layout_widgets ) _layout_widgets = 1;
       }
+      Y += _tree->_prefs.openchild_marginbottom();
     }
   }
+  _layout_h = Y - item_top;
+  _layout_gen = gen;
+}
+
+/*
+  Lay out an item that was skipped by the last draw() or calc_tree(),
+  using the cached heights of the items above it. The tree's layout
+  must be up to date, see Fl_Tree::calc_tree().
+*/
+void Fl_Tree_Item::update_position() {
+  if ( _position_gen == _tree->_position_gen ) return;
+  int X, Y, W;
+  update_position(X, Y, W);
+}
+
+/*
+  Lay out this item and its parents. Returns the position and width
+  of this item's children in X, Y, and W.
+*/
+void Fl_Tree_Item::update_position(int &X, int &Y, int &W) {
+  int lastchild = 1;
+  if ( _parent ) {
+    _parent->update_position(X, Y, W);
+    int t = 0;
+    for ( ; t<_parent->children() && _parent->_children[t] != this; t++ )
+      Y += _parent->_children[t]->_layout_h;
+    lastchild = (t+1 == _parent->children()) ? 1 : 0;
+  } else {
+    _tree->item_origin(X, Y, W);
+  }
+  int child_x;
+  fl_font(_tree->_prefs.labelfont(), _tree->_prefs.labelsize());
+  draw_self(X, Y, W, 0, lastchild, 0, child_x);
+  W -= child_x - X;
+  X = child_x;
 }
 
 
@@ -1478,5 +1597,8 @@ int Fl_Tree_Item::is_visible_r() const {
 /// \version 1.3.3 ABI
 ///
 void Fl_Tree_Item::recalc_tree() {
-  _tree->recalc_tree();
+  // Only this item and its parents need to be measured again
+  for ( Fl_Tree_Item *item = this; item; item = item->_parent )
+    item->_layout_gen = 0;
+  _tree->_tree_w = _tree->_tree_h = -1;
 }
@@ -6,6 +6,10 @@
 
 #include <FL/Fl_Tree_Item_Array.H>
 #include <FL/Fl_Tree_Item.H>
+#include "Fl_Tree_Item_Index.H"
+
+// Arrays with more items than this get a label index on the first lookup
+static const int index_min = 32;
 
 //////////////////////
 // Fl_Tree_Item_Array.cxx
@@ -36,6 +40,7 @@ Fl_Tree_Item_Array::Fl_Tree_Item_Array(int new_chunksize) {
   _size      = 0;
   _flags     = 0;
   _chunksize = new_chunksize;
+  _index     = 0;
 }
 
 /// Destructor. Calls each item's destructor, destroys internal _items array.
@@ -50,6 +55,7 @@ Fl_Tree_Item_Array::Fl_Tree_Item_Array(const Fl_Tree_Item_Array* o) {
   _size      = o->_size;
   _chunksize = o->_chunksize;
   _flags     = o->_flags;
+  _index     = 0;
   for ( int t=0; t<o->_total; t++ ) {
     if ( _flags & MANAGE_ITEM ) {
       _items[t] = new Fl_Tree_Item(o->_items[t]);       // make new copy of item
@@ -68,6 +74,7 @@ Fl_Tree_Item_Array::Fl_Tree_Item_Array(const Fl_Tree_Item_Array* o) {
 ///     and the array will be cleared. total() will return 0.
 ///
 void Fl_Tree_Item_Array::clear() {
+  delete _index; _index = 0;
   if ( _items ) {
     for ( int t=0; t<_total; t++ ) {
       if ( _flags & MANAGE_ITEM )
@@ -127,6 +134,7 @@ void Fl_Tree_Item_Array::insert(int pos, Fl_Tree_Item *new_item) {
   {
     _items[pos]->update_prev_next(pos); // adjust item's prev/next and its neighbors
   }
+  if ( _index ) _index->added(_items, _total, pos);
 }
 
 /// Add an item* to the end of the array.
@@ -145,6 +153,8 @@ void Fl_Tree_Item_Array::add(Fl_Tree_Item *val) {
 /// and the new item will take it's place, and stitched into the linked list.
 ///
 void Fl_Tree_Item_Array::replace(int index, Fl_Tree_Item *newitem) {
+  if ( _index && _items[index] )
+    _index->removed(_items, _total, _items[index], _items[index]->label());
   if ( _items[index] ) {                        // delete if non-zero
     if ( _flags & MANAGE_ITEM )
       // Destroy old item
@@ -156,6 +166,7 @@ void Fl_Tree_Item_Array::replace(int index, Fl_Tree_Item *newitem) {
     // Restitch into linked list
     _items[index]->update_prev_next(index);
   }
+  if ( _index ) _index->added(_items, _total, index);
 }
 
 /// Remove the item at \param[in] index from the array.
@@ -163,6 +174,8 @@ void Fl_Tree_Item_Array::replace(int index, Fl_Tree_Item *newitem) {
 ///     The item will be delete'd (if non-NULL), so its destructor will be called.
 ///
 void Fl_Tree_Item_Array::remove(int index) {
+  if ( _index && _items[index] )
+    _index->removed(_items, _total, _items[index], _items[index]->label());
   if ( _items[index] ) {                        // delete if non-zero
     if ( _flags & MANAGE_ITEM )
       delete _items[index];
@@ -202,6 +215,7 @@ void Fl_Tree_Item_Array::swap(int ax, int bx) {
   Fl_Tree_Item *asave = _items[ax];
   _items[ax] = _items[bx];
   _items[bx] = asave;
+  if ( _index ) _index->reordered();
   if ( _flags & MANAGE_ITEM )
   {
     // Adjust prev/next ptrs
@@ -231,6 +245,7 @@ int Fl_Tree_Item_Array::move(int to, int from) {
       _items[t] = _items[t-1];
   // Move to new position
   _items[to] = item;
+  if ( _index ) _index->reordered();
   // Update all children
   for ( int r=0; r<_total; r++ )        // XXX: excessive to do all children,
     _items[r]->update_prev_next(r);     // XXX: but avoids weird boundary issues
@@ -250,6 +265,7 @@ int Fl_Tree_Item_Array::deparent(int pos) {
   Fl_Tree_Item *item = _items[pos];
   Fl_Tree_Item *prev = item->prev_sibling();
   Fl_Tree_Item *next = item->next_sibling();
+  if ( _index ) _index->removed(_items, _total, item, item->label());
   // Remove from parent's list of children
   _total -= 1;
   for ( int t=pos; t<_total; t++ )
@@ -278,5 +294,67 @@ int Fl_Tree_Item_Array::reparent(Fl_Tree_Item *item, Fl_Tree_Item* newparent, in
   // Attach to new parent and siblings
   _items[pos]->parent(newparent);       // reparent (update_prev_next() needs this)
   _items[pos]->update_prev_next(pos);   // find new siblings
+  if ( _index ) _index->added(_items, _total, pos);
+  return 0;
+}
+
+// Internal: Return the label index, create it if the array is large enough.
+Fl_Tree_Item_Index *Fl_Tree_Item_Array::index() const {
+  if ( !_index && _total > index_min )
+    _index = new Fl_Tree_Item_Index(_items, _total);
+  return _index;
+}
+
+/// Find the first item with the label \p name.
+///
+///     Large arrays build a hash table of the labels on the first call,
+///     so the lookup takes constant time unless several items have the
+///     same label.
+///
+///     \returns the item, or NULL if no item has this label.
+///     \version 1.5.0
+///
+Fl_Tree_Item *Fl_Tree_Item_Array::find_label(const char *name) const {
+  if ( !name ) return 0;
+  if ( index() ) {
+    Fl_Tree_Item *item = 0;
+    switch ( _index->find(name, item) ) {
+      case 0: return 0;                 // no such label
+      case 1: return item;              // unique label
+      default: break;                   // several items, find the first one
+    }
+  }
+  for ( int t=0; t<_total; t++ )
+    if ( _items[t]->label() && strcmp(_items[t]->label(), name) == 0 )
+      return _items[t];
   return 0;
 }
+
+/// Find the position for a new item with the label \p name in a sorted array.
+///
+///     \p dir is 1 if the labels are sorted in ascending order, or -1 if
+///     they are sorted in descending order. Returns the position of the first
+///     item that would follow \p name, found with a binary search.
+///
+///     \returns the position, or -1 if the array is small or not sorted;
+///     the caller must then search the array itself.
+///     \note Internal use only, called by Fl_Tree_Item.
+///     \version 1.5.0
+///
+int Fl_Tree_Item_Array::sorted_position(const char *name, int dir) {
+  if ( !name || !index() ) return -1;
+  return _index->sorted_position(_items, _total, name, dir);
+}
+
+/// Update the label index after the label of \p item was changed.
+///
+///     \p oldlabel is the previous label of \p item, which must not be
+///     freed before this call.
+///     \note Internal use only, called by Fl_Tree_Item::label().
+///     \version 1.5.0
+///
+void Fl_Tree_Item_Array::relabel(Fl_Tree_Item *item, const char *oldlabel) {
+  if ( !_index ) return;
+  _index->removed(_items, _total, item, oldlabel);
+  _index->relabeled(item);
+}
@@ -0,0 +1,143 @@
+//
+// Child label index for Fl_Tree_Item for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Tree_Item_Index.H"
+#include <FL/Fl_Tree_Item.H>
+
+#include <string.h>
+
+
+// FNV-1a hash of a label
+size_t Fl_Tree_Item_Index::Hash::operator()(const char *s) const {
+  size_t h = (size_t)2166136261u;
+  while (*s) {
+    h ^= (unsigned char)*s++;
+    h *= (size_t)16777619u;
+  }
+  return h;
+}
+
+
+bool Fl_Tree_Item_Index::Equal::operator()(const char *a, const char *b) const {
+  return strcmp(a, b) == 0;
+}
+
+
+Fl_Tree_Item_Index::Fl_Tree_Item_Index(Fl_Tree_Item * const *items, int total) {
+  map_.reserve(total);
+  for (int t = 0; t < total; t++)
+    insert_(items[t]);
+  order_[0] = order_[1] = UNKNOWN;
+}
+
+
+/*
+ Return true if a may precede b in ascending (dir > 0) or descending
+ (dir < 0) order. Items without a label are never in order.
+ */
+int Fl_Tree_Item_Index::in_order_(const Fl_Tree_Item *a, const Fl_Tree_Item *b, int dir) {
+  if (!a->label() || !b->label()) return 0;
+  int c = strcmp(a->label(), b->label());
+  return dir > 0 ? c <= 0 : c >= 0;
+}
+
+
+void Fl_Tree_Item_Index::check_order_(Fl_Tree_Item * const *items, int total, int dir) {
+  Order &order = order_[dir > 0 ? 0 : 1];
+  order = SORTED;
+  if (total == 1 && !items[0]->label()) order = UNSORTED;
+  for (int t = 1; t < total && order == SORTED; t++)
+    if (!in_order_(items[t - 1], items[t], dir)) order = UNSORTED;
+}
+
+
+void Fl_Tree_Item_Index::insert_(Fl_Tree_Item *item) {
+  if (!item->label()) return;
+  Map::iterator it = map_.find(item->label());
+  if (it != map_.end()) {
+    it->second.count++;
+  } else {
+    Entry e = { item, 1 };
+    map_[item->label()] = e;
+  }
+}
+
+
+void Fl_Tree_Item_Index::added(Fl_Tree_Item * const *items, int total, int pos) {
+  Fl_Tree_Item *item = items[pos];
+  insert_(item);
+  // Adding an item keeps the children sorted if it is in order with its neighbors
+  for (int i = 0; i < 2; i++) {
+    int dir = i ? -1 : 1;
+    if (order_[i] != SORTED) continue;
+    if (!item->label() ||
+        (pos > 0 && !in_order_(items[pos - 1], item, dir)) ||
+        (pos < total - 1 && !in_order_(item, items[pos + 1], dir)))
+      order_[i] = UNSORTED;
+  }
+}
+
+
+void Fl_Tree_Item_Index::removed(Fl_Tree_Item * const *items, int total,
+                                 const Fl_Tree_Item *item, const char *label) {
+  // Removing an item may sort the remaining children
+  for (int i = 0; i < 2; i++)
+    if (order_[i] == UNSORTED) order_[i] = UNKNOWN;
+  if (!label) return;
+  Map::iterator it = map_.find(label);
+  if (it == map_.end()) return;
+  if (--it->second.count == 0) {
+    map_.erase(it);
+    return;
+  }
+  if (it->second.item != item) return;
+  // The key points to the label of item: find another child with this label
+  Entry e = it->second;
+  map_.erase(it);
+  for (int t = 0; t < total; t++) {
+    if (items[t] != item && items[t]->label() && strcmp(items[t]->label(), label) == 0) {
+      e.item = items[t];
+      map_[items[t]->label()] = e;
+      return;
+    }
+  }
+}
+
+
+int Fl_Tree_Item_Index::find(const char *label, Fl_Tree_Item *&item) const {
+  Map::const_iterator it = map_.find(label);
+  if (it == map_.end()) return 0;
+  if (it->second.count > 1) return -1;
+  item = it->second.item;
+  return 1;
+}
+
+
+int Fl_Tree_Item_Index::sorted_position(Fl_Tree_Item * const *items, int total,
+                                        const char *label, int dir) {
+  Order &order = order_[dir > 0 ? 0 : 1];
+  if (order == UNKNOWN) check_order_(items, total, dir);
+  if (order != SORTED) return -1;
+  // find the first child that would follow label
+  int lo = 0, hi = total;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    int c = strcmp(items[mid]->label(), label);
+    if (dir > 0 ? c > 0 : c < 0) hi = mid;
+    else lo = mid + 1;
+  }
+  return lo;
+}
@@ -18,7 +18,9 @@
 #include <FL/Fl.H>
 #include "Fl_System_Driver.H"
 
-#include <stdlib.h>
+#include <atomic>
+#include <new>
+#include <unordered_set>
 
 /*
    From Bill:
@@ -66,13 +68,78 @@
 
 #ifndef FL_DOXYGEN
 
-static constexpr int AWAKE_RING_SIZE = 1024;
-Fl_Awake_Handler *Fl_System_Driver::awake_ring_ = nullptr;
-void **Fl_System_Driver::awake_data_ = nullptr;
-int Fl_System_Driver::awake_ring_size_ = 0;
-int Fl_System_Driver::awake_ring_head_ = 0;
-int Fl_System_Driver::awake_ring_tail_ = 0;
-bool Fl_System_Driverawake_pending_ = false;
+/*
+ The awake handlers are kept in a lock-free multi-producer, single-consumer
+ queue (an intrusive linked list as described by Dmitry Vyukov). Any thread
+ can append a node with a single atomic exchange, only the main thread
+ removes nodes. The queue has no size limit.
+
+ The main thread is woken up only by the first handler after the queue was
+ drained, all handlers added in the meantime are processed in the same batch.
+
+ Fl::awake_once() remembers the handlers that are in the queue in a hash
+ table, which is the only part that needs lock_ring().
+*/
+
+namespace {
+
+struct Awake_Node {
+  std::atomic<Awake_Node*> next;
+  Fl_Awake_Handler func;
+  void *data;
+  bool once;
+};
+
+struct Awake_Key {
+  Fl_Awake_Handler func;
+  void *data;
+  bool operator==(const Awake_Key &k) const { return func == k.func && data == k.data; }
+};
+
+struct Awake_Key_Hash {
+  size_t operator()(const Awake_Key &k) const {
+    return std::hash<void*>()((void*)k.func) ^ (std::hash<void*>()(k.data) * 31);
+  }
+};
+
+} // namespace
+
+static Awake_Node awake_stub;
+static std::atomic<Awake_Node*> awake_head(&awake_stub); // last node, producers
+static Awake_Node *awake_tail = &awake_stub;             // first node, consumer
+static std::atomic<bool> awake_signaled(false);
+static std::unordered_set<Awake_Key, Awake_Key_Hash> *awake_once_set = nullptr;
+
+static void awake_push(Awake_Node *node) {
+  node->next.store(nullptr, std::memory_order_relaxed);
+  Awake_Node *prev = awake_head.exchange(node, std::memory_order_acq_rel);
+  prev->next.store(node, std::memory_order_release);
+}
+
+// Returns the first node or nullptr if the queue is empty, or if another
+// thread has not finished adding a node yet. That thread will wake us up.
+static Awake_Node *awake_pop() {
+  Awake_Node *tail = awake_tail;
+  Awake_Node *next = tail->next.load(std::memory_order_acquire);
+  if (tail == &awake_stub) {
+    if (!next) return nullptr;
+    awake_tail = tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+  if (next) {
+    awake_tail = next;
+    return tail;
+  }
+  if (tail != awake_head.load(std::memory_order_acquire))
+    return nullptr;
+  awake_push(&awake_stub);
+  next = tail->next.load(std::memory_order_acquire);
+  if (next) {
+    awake_tail = next;
+    return tail;
+  }
+  return nullptr;
+}
 
 #endif
 
@@ -89,97 +156,70 @@ bool Fl_System_Driverawake_pending_ = false;
 
  \param[in] func The function to call when the main thread is awake.
  \param[in] data The user data to pass to the function.
- \param[in] once If true, the handler will be added only once, removing any
-                 existing handler with the same function pointer and data pointer.
- \return 0 on success, -1 if the ring buffer is full.
+ \param[in] once If true, the handler will not be added if a handler with
+                 the same function pointer and data pointer is already waiting.
+ \return 0 on success, -1 if memory allocation failed.
  */
 int Fl_System_Driver::push_awake_handler(Fl_Awake_Handler func, void *data, bool once)
 {
-  int ret = 0;
-  Fl::system_driver()->lock_ring();
-
-  // Allocate the ring buffers if we have not done so yet.
-  if (!awake_ring_) {
-    awake_ring_size_ = AWAKE_RING_SIZE;
-    awake_ring_ = (Fl_Awake_Handler*)malloc(awake_ring_size_*sizeof(Fl_Awake_Handler));
-    awake_data_ = (void**)malloc(awake_ring_size_*sizeof(void*));
-    // explicitly initialize the head and tail indices
-    awake_ring_head_= awake_ring_tail_ = 0;
-  }
-
-  // If we want to add the handler only once, go through the list of existing
-  // handlers and remove any handler with the same function pointer
-  // and data pointer.
   if (once) {
-    int src = awake_ring_tail_;
-    int dst = awake_ring_tail_;
-    while (src != awake_ring_head_) {
-      if ((awake_ring_[src] != func) || (awake_data_[src] != data)) {
-        if (src != dst) {
-          awake_ring_[dst] = awake_ring_[src];
-          awake_data_[dst] = awake_data_[src];
-        }
-        dst++;
-        if (dst >= awake_ring_size_) dst = 0; // wrap around
-      }
-      src++;
-      if (src >= awake_ring_size_) src = 0; // wrap around
-    }
-    awake_ring_head_ = dst;
+    Awake_Key key = { func, data };
+    Fl::system_driver()->lock_ring();
+    if (!awake_once_set)
+      awake_once_set = new std::unordered_set<Awake_Key, Awake_Key_Hash>;
+    bool added = awake_once_set->insert(key).second;
+    Fl::system_driver()->unlock_ring();
+    if (!added)
+      return 0;
   }
-
-  // The next head index we will want (not the current index):
-  // We use this to check if the ring-buffer is full or not
-  // (and to update awake_ring_head_ if we do use the current index.)
-  int next_head = awake_ring_head_ + 1;
-  if (next_head >= awake_ring_size_) {
-    next_head = 0;
-  }
-  // check that the ring buffer is not full
-  if (next_head == awake_ring_tail_) {
-    // ring is full. Return -1 as an error indicator.
-    ret = -1;
-  } else {
-    awake_ring_[awake_ring_head_] = func;
-    awake_data_[awake_ring_head_] = data;
-    awake_ring_head_ = next_head;
-  }
-
-  Fl::system_driver()->unlock_ring();
-  return ret;
+  Awake_Node *node = new (std::nothrow) Awake_Node;
+  if (!node)
+    return -1;
+  node->func = func;
+  node->data = data;
+  node->once = once;
+  awake_push(node);
+  return 0;
 }
 
 /**
- \brief Gets the last stored awake handler for use in awake().
+ \brief Gets the oldest stored awake handler for use in awake().
  \internal Used in the main event loop when an Awake message is received.
+ Must only be called by the main thread.
  */
 int Fl_System_Driver::pop_awake_handler(Fl_Awake_Handler &func, void *&data)
 {
-  int ret = 0;
-  Fl::system_driver()->lock_ring();
-  if ((!awake_ring_) || (awake_ring_head_ == awake_ring_tail_)) {
-    ret = -1;
-  } else {
-    func = awake_ring_[awake_ring_tail_];
-    data = awake_data_[awake_ring_tail_];
-    ++awake_ring_tail_;
-    if (awake_ring_tail_ >= awake_ring_size_) {
-      awake_ring_tail_ = 0;
-    }
+  // Any handler added after this point wakes up the main thread again.
+  // This must be a read-modify-write (or be followed by a full fence):
+  // it synchronizes with the exchange() of every thread that added a
+  // handler before, so the queue check below sees their nodes. A plain
+  // store could be reordered after the check, and a handler added in
+  // between would neither be found nor wake up the main thread.
+  awake_signaled.exchange(false);
+  Awake_Node *node = awake_pop();
+  if (!node)
+    return -1;
+  func = node->func;
+  data = node->data;
+  if (node->once) {
+    // a new awake_once() call must add the handler again from now on
+    Awake_Key key = { func, data };
+    Fl::system_driver()->lock_ring();
+    awake_once_set->erase(key);
+    Fl::system_driver()->unlock_ring();
   }
-  Fl::system_driver()->unlock_ring();
-  return ret;
+  delete node;
+  return 0;
 }
 
 /**
- \brief Checks if the awake ring buffer is empty.
+ \brief Checks if the awake handler queue is empty.
  \internal Used in the main event loop when an Awake message is received.
+ Must only be called by the main thread.
  */
 bool Fl_System_Driver::awake_ring_empty() {
-  Fl::system_driver()->lock_ring();
-  bool retval = (awake_ring_head_ == awake_ring_tail_);
-  Fl::system_driver()->unlock_ring();
-  return retval;
+  return awake_tail == &awake_stub &&
+         !awake_stub.next.load(std::memory_order_acquire);
 }
 
 /**
@@ -235,10 +275,10 @@ void Fl::awake(void *v) {
  be run by the main thread, passing optional user data. The callback will be
  executed during the main thread's next event handling cycle.
 
- The queue holding the list of handlers is limited to 1024 entries.
- If the queue is full, the function will return -1 and the callback will not be
- scheduled. However the main thread will still be woken up to process any
- other pending events.
+ The queue holding the list of handlers has no size limit, and adding a
+ handler never blocks the calling thread. The main thread processes all
+ handlers that were scheduled until it gets to them in one batch, in the
+ order they were scheduled.
 
  \note If user_data points to dynamically allocated memory, it is the
  responsibility of the caller to ensure that the memory is valid until the
@@ -247,7 +287,7 @@ void Fl::awake(void *v) {
  several seconds.
 
  \return 0 if the callback was successfully scheduled
- \return -1 if the queue is full.
+ \return -1 if the system ran out of memory.
 
  \see Fl::awake()
  \see Fl::awake_once(Fl_Awake_Handler, void*)
@@ -255,7 +295,8 @@ void Fl::awake(void *v) {
 */
 int Fl::awake(Fl_Awake_Handler handler, void *user_data) {
   int ret = Fl_System_Driver::push_awake_handler(handler, user_data, false);
-  Fl::awake();
+  if (!awake_signaled.exchange(true))
+    Fl::awake();
   return ret;
 }
 
@@ -263,21 +304,22 @@ int Fl::awake(Fl_Awake_Handler handler, void *user_data) {
  \brief Schedules a callback to be executed once by the main thread, then wakes up the main thread.
 
  This function lets a worker thread request that a specific callback function
- be run by the main thread, passing optional user data. If a callback with the
- same user_data is already scheduled, the previous entry will be removed and
- the new entry will be appended to the list.
+ be run by the main thread, passing optional user data. If the same callback
+ with the same user_data is already scheduled and was not called yet, the
+ call is merged with the scheduled one and the callback will be called only
+ once. This check takes constant time.
 
  \return 0 if the callback was successfully scheduled
- \return -1 if the queue is full.
+ \return -1 if the system ran out of memory.
 
  \see Fl::awake()
  \see Fl::awake(Fl_Awake_Handler, void*)
  \see \ref advanced_multithreading
 */
 int Fl::awake_once(Fl_Awake_Handler handler, void *user_data) {
-  // TODO: remove any previous entry with the same handler and user_data
   int ret = Fl_System_Driver::push_awake_handler(handler, user_data, true);
-  Fl::awake();
+  if (!awake_signaled.exchange(true))
+    Fl::awake();
   return ret;
 }
 
@@ -90,11 +90,11 @@ static bool have_xfixes = false;
 #    include <X11/extensions/Xrender.h>
 #  endif
 
-#  if USE_POLL
+#  if USE_POLL || USE_EPOLL
 #    include <poll.h>
 #  else
 #    define POLLIN 1
-#  endif /* USE_POLL */
+#  endif /* USE_POLL || USE_EPOLL */
 
 extern Fl_Widget *fl_selection_requestor;
 extern Fl_Window *fl_xmousewin;
@@ -28,6 +28,7 @@
 #endif
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 #include <pwd.h>
 #include <unistd.h>
@@ -315,6 +316,33 @@ bool Fl_Posix_System_Driver::probe_for_GTK(int major, int minor, void **p_ptr_gt
 int Fl_Posix_System_Driver::close_fd(int fd) { return close(fd); }
 
 
+void *Fl_Posix_System_Driver::map_file(const char *filename, size_t *size) {
+  *size = 0;
+  int fd = ::open(filename, O_RDONLY);
+  if (fd < 0) return NULL;
+  struct stat st;
+  void *addr = NULL;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      addr = NULL;
+    } else {
+      *size = (size_t)st.st_size;
+#if defined(POSIX_MADV_SEQUENTIAL)
+      posix_madvise(addr, *size, POSIX_MADV_SEQUENTIAL);
+#endif
+    }
+  }
+  close(fd); // the mapping stays valid
+  return addr;
+}
+
+
+void Fl_Posix_System_Driver::unmap_file(void *addr, size_t size) {
+  if (addr) munmap(addr, size);
+}
+
+
 ////////////////////////////////////////////////////////////////
 // POSIX threading...
 #if defined(HAVE_PTHREAD)
@@ -432,6 +460,11 @@ int Fl_Posix_System_Driver::lock() {
     // Fl::wait().
     Fl::add_fd(thread_filedes[0], FL_READ, thread_awake_cb);
 
+    // Handlers that were scheduled before the pipe existed did not wake up
+    // the main thread, and the following ones will not try again.
+    if (!Fl_System_Driver::awake_ring_empty())
+      awake(nullptr);
+
     // Set lock/unlock functions for this system, using a system-supplied
     // recursive mutex if supported...
 #  ifdef HAVE_PTHREAD_MUTEX_RECURSIVE
@@ -456,7 +489,7 @@ void Fl_Posix_System_Driver::unlock() {
   fl_unlock_function();
 }
 
-// Mutex code for the awake ring buffer
+// Mutex code for the awake handler queue
 static pthread_mutex_t *ring_mutex;
 
 void Fl_Posix_System_Driver::unlock_ring() {
@@ -471,6 +504,33 @@ void Fl_Posix_System_Driver::lock_ring() {
   pthread_mutex_lock(ring_mutex);
 }
 
+struct thread_start {
+  void (*func)(void *);
+  void *data;
+};
+
+static void *thread_start_cb(void *p) {
+  thread_start start = *(thread_start *)p;
+  delete (thread_start *)p;
+  start.func(start.data);
+  return NULL;
+}
+
+int Fl_Posix_System_Driver::create_thread(void (*func)(void *), void *data) {
+  // Background threads report back with Fl::awake() which needs Fl::lock()
+  if (!thread_filedes[1]) return -1;
+  thread_start *start = new thread_start;
+  start->func = func;
+  start->data = data;
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, thread_start_cb, start) != 0) {
+    delete start;
+    return -1;
+  }
+  pthread_detach(thread);
+  return 0;
+}
+
 #else // ! HAVE_PTHREAD
 
 void Fl_Posix_System_Driver::awake(void*) {}
@@ -18,7 +18,11 @@
 #include <sys/time.h>
 #include "Fl_Unix_Screen_Driver.H"
 
-#if USE_POLL
+#if USE_EPOLL
+#  include <unistd.h>
+int Fl_Unix_Screen_Driver::epfd = -1;
+int Fl_Unix_Screen_Driver::nalways = 0;
+#elif USE_POLL
 pollfd *Fl_Unix_Screen_Driver::pollfds = NULL;
 #else
 fd_set Fl_Unix_Screen_Driver::fdsets[3];
@@ -33,6 +37,79 @@ void (*fl_lock_function)() = nothing;
 void (*fl_unlock_function)() = nothing;
 
 
+#if USE_EPOLL
+
+// Maximum number of ready descriptors handled per wakeup, others are
+// returned by the next epoll_wait() call
+static const int max_epoll_events = 64;
+
+int Fl_Unix_Screen_Driver::epoll_fd() {
+  if (epfd < 0)
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+  return epfd;
+}
+
+// Call the callbacks of descriptor f for the events in revents. The epoll
+// event bits have the same values as the poll() bits on Linux.
+static void epoll_dispatch(int f, int revents) {
+  static const short bits[3] = { POLLIN, POLLOUT, POLLERR };
+  if (f < 0 || f >= Fl_Unix_Screen_Driver::maxfd) return;
+  // Callbacks may add or remove descriptors, work on a copy
+  Fl_Unix_Screen_Driver::FD e = Fl_Unix_Screen_Driver::fd[f];
+  int done[3], ndone = 0;
+  for (int k = 0; k < 3; k++) {
+    if (!e.slot[k].cb) continue;
+    if (!(revents & (bits[k] | POLLERR | POLLHUP))) continue;
+    int i;
+    for (i = 0; i < ndone; i++) if (done[i] == e.slot[k].id) break;
+    if (i < ndone) continue;      // same Fl::add_fd() call, already done
+    if (f >= Fl_Unix_Screen_Driver::maxfd ||
+        Fl_Unix_Screen_Driver::fd[f].slot[k].id != e.slot[k].id)
+      continue;                   // removed by a previous callback
+    done[ndone++] = e.slot[k].id;
+    e.slot[k].cb(f, e.slot[k].arg);
+  }
+}
+
+// This is never called with time_to_wait < 0.0:
+// It should return negative on error, 0 if nothing happens before
+// timeout, and >0 if any callbacks were done.
+int Fl_Unix_Screen_Driver::poll_or_select_with_delay(double time_to_wait) {
+  epoll_event ev[max_epoll_events];
+  int timeout = -1;
+  if (nalways)
+    timeout = 0;
+  else if (time_to_wait < 2147483.648)
+    timeout = int(time_to_wait*1000 + .5);
+
+  fl_unlock_function();
+  int n = epoll_wait(epoll_fd(), ev, max_epoll_events, timeout);
+  fl_lock_function();
+
+  for (int i = 0; i < n; i++)
+    epoll_dispatch(ev[i].data.fd, ev[i].events);
+  if (nalways) {
+    if (n < 0) n = 0;
+    for (int f = 0; f < maxfd; f++) {
+      if (fd[f].always) {
+        epoll_dispatch(f, fd[f].events);
+        n++;
+      }
+    }
+  }
+  return n;
+}
+
+
+int Fl_Unix_Screen_Driver::poll_or_select() {
+  if (!nfds) return 0; // nothing to select or poll
+  if (nalways) return nalways;
+  epoll_event ev;
+  return epoll_wait(epoll_fd(), &ev, 1, 0);
+}
+
+#else // USE_EPOLL
+
 // This is never called with time_to_wait < 0.0:
 // It should return negative on error, 0 if nothing happens before
 // timeout, and >0 if any callbacks were done.
@@ -99,3 +176,5 @@ int Fl_Unix_Screen_Driver::poll_or_select() {
   return ::select(maxfd+1,&fdt[0],&fdt[1],&fdt[2],&t);
 #  endif
 }
+
+#endif // USE_EPOLL
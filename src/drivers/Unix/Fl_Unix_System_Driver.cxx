@@ -703,6 +703,87 @@ const char *Fl_Unix_System_Driver::filename_name(const char *name) {
 }
 
 
+#if USE_EPOLL
+
+// Event types that have their own callback slot in Fl_Unix_Screen_Driver::FD
+static const short fd_slot_events[3] = { POLLIN, POLLOUT, POLLERR };
+
+// Tell epoll which events to watch for descriptor n.
+static void fd_epoll_update(int n, bool added) {
+  Fl_Unix_Screen_Driver::FD &e = Fl_Unix_Screen_Driver::fd[n];
+  epoll_event ev;
+  ev.events = e.events & (POLLIN | POLLOUT); // errors are always reported
+  ev.data.u64 = 0;
+  ev.data.fd = n;
+  int epfd = Fl_Unix_Screen_Driver::epoll_fd();
+  int ret = epoll_ctl(epfd, added ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, n, &ev);
+  if (ret < 0 && errno == ENOENT) // closed and reopened without remove_fd()
+    ret = epoll_ctl(epfd, EPOLL_CTL_ADD, n, &ev);
+  if (ret < 0 && errno == EEXIST)
+    ret = epoll_ctl(epfd, EPOLL_CTL_MOD, n, &ev);
+  if (ret < 0 && errno == EPERM) { // regular files are always ready
+    e.always = 1;
+    Fl_Unix_Screen_Driver::nalways++;
+  }
+}
+
+void Fl_Unix_System_Driver::add_fd(int n, int events, void (*cb)(int, void*), void *v) {
+  static int next_id = 0;
+  remove_fd(n, events);
+  if (n < 0 || !(events & (POLLIN | POLLOUT | POLLERR))) return;
+  if (n >= Fl_Unix_Screen_Driver::maxfd) {
+    int size = 2 * Fl_Unix_Screen_Driver::maxfd;
+    if (size <= n) size = n + 16;
+    Fl_Unix_Screen_Driver::FD *temp = (Fl_Unix_Screen_Driver::FD*)
+      realloc(Fl_Unix_Screen_Driver::fd, size * sizeof(Fl_Unix_Screen_Driver::FD));
+    if (!temp) return;
+    memset(temp + Fl_Unix_Screen_Driver::maxfd, 0,
+           (size - Fl_Unix_Screen_Driver::maxfd) * sizeof(Fl_Unix_Screen_Driver::FD));
+    Fl_Unix_Screen_Driver::fd = temp;
+    Fl_Unix_Screen_Driver::maxfd = size;
+  }
+  Fl_Unix_Screen_Driver::FD &e = Fl_Unix_Screen_Driver::fd[n];
+  bool added = (e.events == 0);
+  int id = ++next_id;
+  for (int k = 0; k < 3; k++) {
+    if (events & fd_slot_events[k]) {
+      e.slot[k].cb = cb;
+      e.slot[k].arg = v;
+      e.slot[k].id = id;
+      e.events |= fd_slot_events[k];
+    }
+  }
+  if (added) Fl_Unix_Screen_Driver::nfds++;
+  if (!e.always) fd_epoll_update(n, added);
+}
+
+void Fl_Unix_System_Driver::remove_fd(int n, int events) {
+  if (n < 0 || n >= Fl_Unix_Screen_Driver::maxfd) return;
+  Fl_Unix_Screen_Driver::FD &e = Fl_Unix_Screen_Driver::fd[n];
+  if (!e.events) return;
+  for (int k = 0; k < 3; k++) {
+    if (events & fd_slot_events[k]) {
+      e.slot[k].cb = 0;
+      e.slot[k].id = 0;
+      e.events &= ~fd_slot_events[k];
+    }
+  }
+  if (e.events) {
+    if (!e.always) fd_epoll_update(n, false);
+    return;
+  }
+  Fl_Unix_Screen_Driver::nfds--;
+  if (e.always) {
+    e.always = 0;
+    Fl_Unix_Screen_Driver::nalways--;
+  } else {
+    epoll_event ev; // ignored, but must not be NULL in old kernels
+    epoll_ctl(Fl_Unix_Screen_Driver::epoll_fd(), EPOLL_CTL_DEL, n, &ev);
+  }
+}
+
+#else // USE_EPOLL
+
 static int fd_array_size = 0;
 
 void Fl_Unix_System_Driver::add_fd(int n, int events, void (*cb)(int, void*), void *v) {
@@ -745,10 +826,6 @@ void Fl_Unix_System_Driver::add_fd(int n, int events, void (*cb)(int, void*), vo
 #  endif
 }
 
-void Fl_Unix_System_Driver::add_fd(int n, void (*cb)(int, void*), void* v) {
-  add_fd(n, POLLIN, cb, v);
-}
-
 void Fl_Unix_System_Driver::remove_fd(int n, int events) {
   int i,j;
 # if !USE_POLL
@@ -786,6 +863,12 @@ void Fl_Unix_System_Driver::remove_fd(int n, int events) {
 #  endif
 }
 
+#endif // USE_EPOLL
+
+void Fl_Unix_System_Driver::add_fd(int n, void (*cb)(int, void*), void* v) {
+  add_fd(n, POLLIN, cb, v);
+}
+
 void Fl_Unix_System_Driver::remove_fd(int n) {
   remove_fd(n, -1);
 }
@@ -219,10 +219,14 @@ int Fl_WinAPI_System_Driver::putenv(const char *var) {
   return ret;
 }
 
+// open() and fopen() convert the file name into local buffers, so that
+// images can be loaded in background threads (see Fl_Shared_Image::get_async())
 int Fl_WinAPI_System_Driver::open(const char *fnam, int oflags, int pmode) {
-  utf8_to_wchar(fnam, wbuf);
-  if (pmode == -1) return _wopen(wbuf, oflags);
-  else return _wopen(wbuf, oflags, pmode);
+  wchar_t *wname = NULL;
+  utf8_to_wchar(fnam, wname);
+  int ret = (pmode == -1) ? _wopen(wname, oflags) : _wopen(wname, oflags, pmode);
+  free(wname);
+  return ret;
 }
 
 int Fl_WinAPI_System_Driver::open_ext(const char *fnam, int binary, int oflags, int pmode) {
@@ -232,9 +236,13 @@ int Fl_WinAPI_System_Driver::open_ext(const char *fnam, int binary, int oflags,
 }
 
 FILE *Fl_WinAPI_System_Driver::fopen(const char *fnam, const char *mode) {
-  utf8_to_wchar(fnam, wbuf);
-  utf8_to_wchar(mode, wbuf1);
-  return _wfopen(wbuf, wbuf1);
+  wchar_t *wname = NULL, *wmode = NULL;
+  utf8_to_wchar(fnam, wname);
+  utf8_to_wchar(mode, wmode);
+  FILE *ret = _wfopen(wname, wmode);
+  free(wname);
+  free(wmode);
+  return ret;
 }
 
 int Fl_WinAPI_System_Driver::system(const char *cmd) {
@@ -1129,6 +1137,58 @@ void Fl_WinAPI_System_Driver::awake(void* msg) {
   PostThreadMessage( main_thread, fl_wake_msg, (WPARAM)msg, 0);
 }
 
+struct thread_start {
+  void (*func)(void *);
+  void *data;
+};
+
+static DWORD WINAPI thread_start_cb(LPVOID p) {
+  thread_start start = *(thread_start *)p;
+  delete (thread_start *)p;
+  start.func(start.data);
+  return 0;
+}
+
+int Fl_WinAPI_System_Driver::create_thread(void (*func)(void *), void *data) {
+  // Background threads report back with Fl::awake() which needs Fl::lock()
+  if (!main_thread) return -1;
+  thread_start *start = new thread_start;
+  start->func = func;
+  start->data = data;
+  HANDLE thread = CreateThread(NULL, 0, thread_start_cb, start, 0, NULL);
+  if (!thread) {
+    delete start;
+    return -1;
+  }
+  CloseHandle(thread);
+  return 0;
+}
+
 int Fl_WinAPI_System_Driver::close_fd(int fd) {
   return _close(fd);
 }
+
+void *Fl_WinAPI_System_Driver::map_file(const char *filename, size_t *size) {
+  *size = 0;
+  HANDLE file = CreateFileW(utf8_to_wchar(filename, wbuf), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file == INVALID_HANDLE_VALUE) return NULL;
+  void *addr = NULL;
+  LARGE_INTEGER file_size;
+  if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0 &&
+      (ULONGLONG)file_size.QuadPart <= (size_t)-1) {
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping) {
+      addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      if (addr) *size = (size_t)file_size.QuadPart;
+      CloseHandle(mapping); // the view keeps the mapping alive
+    }
+  }
+  CloseHandle(file);
+  return addr;
+}
+
+void Fl_WinAPI_System_Driver::unmap_file(void *addr, size_t) {
+  if (addr) UnmapViewOfFile(addr);
+}
@@ -47,6 +47,7 @@
 #include "Fl_Xlib_Graphics_Driver.H"
 #include "../X11/Fl_X11_Screen_Driver.H"
 #include "../X11/Fl_X11_Window_Driver.H"
+#include "Fl_Xlib_Pixel_Converters.H"
 #  include <FL/Fl.H>
 #  include <FL/fl_draw.H>
 #  include <FL/platform.H>
@@ -61,6 +62,11 @@
 #    define RepeatPad  2
 #  endif
 #endif // HAVE_XRENDER
+#if HAVE_XSHM
+#  include <X11/extensions/XShm.h>
+#  include <sys/ipc.h>
+#  include <sys/shm.h>
+#endif // HAVE_XSHM
 
 static XImage xi;       // template used to pass info to X
 static int bytes_per_pixel;
@@ -69,6 +75,7 @@ static int scanline_mask;
 
 static void (*converter)(const uchar *from, uchar *to, int w, int delta);
 static void (*mono_converter)(const uchar *from, uchar *to, int w, int delta);
+static Fl_Xlib_Simd_Converters simd;    // SIMD converters of this CPU, if any
 
 static int dir;         // direction-alternator
 static int ri,gi,bi;    // saved error-diffusion value
@@ -310,19 +317,26 @@ static void rrr_converter(const uchar *from, uchar *to, int w, int delta) {
   U32 *t = (U32*)to; for (; w--; from += delta) *t++ = f
 #  endif
 
+// Convert the first pixels with the SIMD converter 'f' if there is one
+#  define SIMD32(f) \
+  if (f) {int n = f(from, to, w, delta); from += n*delta; to += n*4; w -= n;}
+
 static void rgbx_converter(const uchar *from, uchar *to, int w, int delta) {
   INNARDS32((unsigned(from[0])<<24)+(from[1]<<16)+(from[2]<<8));
 }
 
 static void xbgr_converter(const uchar *from, uchar *to, int w, int delta) {
+  SIMD32(simd.xbgr);
   INNARDS32((from[0])+(from[1]<<8)+(from[2]<<16));
 }
 
 static void xrgb_converter(const uchar *from, uchar *to, int w, int delta) {
+  SIMD32(simd.xrgb);
   INNARDS32((from[0]<<16)+(from[1]<<8)+(from[2]));
 }
 
 static void argb_premul_converter(const uchar *from, uchar *to, int w, int delta) {
+  SIMD32(simd.argb_premul);
   INNARDS32((unsigned(from[3]) << 24) +
              (((from[0] * from[3]) / 255) << 16) +
              (((from[1] * from[3]) / 255) << 8) +
@@ -366,6 +380,7 @@ static void figure_out_visual() {
 
   fl_xpixel(FL_BLACK); // setup fl_redmask, etc, in fl_color.cxx
   fl_xpixel(FL_WHITE); // also make sure white is allocated
+  simd = fl_xlib_simd_converters();
 
   static XPixmapFormatValues *pfvlist;
   static int FL_NUM_pfv;
@@ -469,6 +484,155 @@ static void figure_out_visual() {
 
 #  define MAXBUFFER 0x40000 // 256k
 
+#if HAVE_XSHM
+////////////////////////////////////////////////////////////////
+// MIT-SHM support: large images are converted into shared memory
+// segments that the X server reads directly, instead of being copied
+// over the connection by XPutImage().
+
+#  define MINSHMSIZE 0x10000       // 64k: smaller images use XPutImage()
+#  define MAXSHMSIZE 0x1000000     // 16M: larger images are sent in bands
+#  define SHMSEGMENTS 4            // number of segments in the pool
+
+// A segment is busy from the XShmPutImage() that reads it until the next
+// XSync(), after which the X server is done with it.
+struct Fl_Xlib_Shm_Segment {
+  XShmSegmentInfo info;
+  long size;                       // 0 if not allocated
+  bool busy;
+};
+
+static Fl_Xlib_Shm_Segment shm_segments[SHMSEGMENTS];
+static Display *shm_display;       // display the segments are attached to
+static int shm_ok;                 // 1 if the display can use MIT-SHM, 0 if not
+static bool shm_error;             // set by shm_error_handler()
+
+static int shm_error_handler(Display *, XErrorEvent *) {
+  shm_error = true;
+  return 0;
+}
+
+static void shm_free(Fl_Xlib_Shm_Segment &seg, bool detach) {
+  if (!seg.size) return;
+  if (detach) XShmDetach(fl_display, &seg.info);
+  shmdt(seg.info.shmaddr);
+  seg.size = 0;
+  seg.busy = false;
+}
+
+// Create a segment of 'size' bytes and attach it to the X server.
+// Disables MIT-SHM if the server can't attach it, e.g. if it is remote.
+static bool shm_alloc(Fl_Xlib_Shm_Segment &seg, long size) {
+  seg.info.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+  if (seg.info.shmid < 0) return false;
+  seg.info.shmaddr = (char *)shmat(seg.info.shmid, 0, 0);
+  if (seg.info.shmaddr == (char *)-1) {
+    shmctl(seg.info.shmid, IPC_RMID, 0);
+    return false;
+  }
+  seg.info.readOnly = True;
+  XSync(fl_display, False);        // report earlier errors to the usual handler
+  shm_error = false;
+  XErrorHandler old_handler = XSetErrorHandler(shm_error_handler);
+  XShmAttach(fl_display, &seg.info);
+  XSync(fl_display, False);
+  XSetErrorHandler(old_handler);
+  shmctl(seg.info.shmid, IPC_RMID, 0); // removed when both sides have detached
+  if (shm_error) {
+    shmdt(seg.info.shmaddr);
+    shm_ok = 0;
+    return false;
+  }
+  seg.size = size;
+  seg.busy = false;
+  return true;
+}
+
+// Return a segment of at least 'size' bytes that the X server does not
+// read from anymore, or NULL if MIT-SHM can't be used.
+static Fl_Xlib_Shm_Segment *shm_segment(long size) {
+  if (shm_display != fl_display) { // first use, or display was reopened
+    for (int i = 0; i < SHMSEGMENTS; i++) shm_free(shm_segments[i], false);
+    shm_display = fl_display;
+    shm_ok = XShmQueryExtension(fl_display) ? 1 : 0;
+  }
+  if (!shm_ok) return 0;
+  Fl_Xlib_Shm_Segment *seg = 0;
+  for (int pass = 0; pass < 2 && !seg; pass++) {
+    if (pass) {                    // all segments busy: wait for the X server
+      XSync(fl_display, False);
+      for (int i = 0; i < SHMSEGMENTS; i++) shm_segments[i].busy = false;
+    }
+    // use the smallest free segment that is large enough, or an empty slot
+    for (int i = 0; i < SHMSEGMENTS; i++) {
+      Fl_Xlib_Shm_Segment *s = shm_segments + i;
+      if (!s->busy && s->size >= size && (!seg || s->size < seg->size)) seg = s;
+    }
+    for (int i = 0; i < SHMSEGMENTS && !seg; i++)
+      if (!shm_segments[i].size) seg = shm_segments + i;
+  }
+  if (!seg) {                      // all segments too small: replace the smallest
+    seg = shm_segments;
+    for (int i = 1; i < SHMSEGMENTS; i++)
+      if (shm_segments[i].size < seg->size) seg = shm_segments + i;
+  }
+  if (seg->size < size) {
+    shm_free(*seg, true);
+    size = (size + MINSHMSIZE - 1) & ~(long)(MINSHMSIZE - 1);
+    if (!shm_alloc(*seg, size)) return 0;
+  }
+  return seg;
+}
+
+// Convert the image into shared memory and draw it with XShmPutImage().
+// Returns false without drawing anything if the image is small or if
+// MIT-SHM can't be used.
+static bool shm_innards(const uchar *buf, int X, int Y, int W, int dx, int dy,
+                        int w, int h, int delta, int linedelta,
+                        void (*conv)(const uchar *from, uchar *to, int w, int delta),
+                        Fl_Draw_Image_Cb cb, void *userdata, GC gc)
+{
+  long linesize = (w*bytes_per_pixel+scanline_add)&scanline_mask;
+  if (linesize*h < MINSHMSIZE) return false;
+  int blocking = h;
+  if (linesize*h > MAXSHMSIZE) blocking = int(MAXSHMSIZE/linesize);
+  if (blocking < 1) blocking = 1;
+  // All bands have at most the size of the first one, so once its segment
+  // is allocated, shm_segment() finds a segment for every band.
+  Fl_Xlib_Shm_Segment *seg = shm_segment(linesize*blocking);
+  if (!seg) return false;
+  STORETYPE *linebuf = 0;
+  if (buf) buf += delta*dx+linedelta*dy;
+  else linebuf = new STORETYPE[(W*delta+(sizeof(STORETYPE)-1))/sizeof(STORETYPE)];
+  xi.bytes_per_line = int(linesize);
+  for (int j=0; j<h; ) {
+    if (!seg) seg = shm_segment(linesize*blocking);
+    if (!seg) break;
+    uchar *to = (uchar *)seg->info.shmaddr;
+    int k;
+    for (k = 0; j<h && k<blocking; k++, j++) {
+      if (buf) {
+        conv(buf, to, w, delta);
+        buf += linedelta;
+      } else {
+        cb(userdata, dx, dy+j, w, (uchar*)linebuf);
+        conv((uchar*)linebuf, to, w, delta);
+      }
+      to += linesize;
+    }
+    xi.data = seg->info.shmaddr;
+    xi.obdata = (char *)&seg->info;
+    xi.height = k;                 // the server checks that the image fits in the segment
+    XShmPutImage(fl_display, fl_window, gc, &xi, 0, 0, X+dx, Y+dy+j-k, w, k, False);
+    seg->busy = true;
+    seg = 0;
+  }
+  xi.obdata = 0;
+  delete[] linebuf;
+  return true;
+}
+#endif // HAVE_XSHM
+
 static void innards(const uchar *buf, int X, int Y, int W, int H,
                     int delta, int linedelta, int mono,
                     Fl_Draw_Image_Cb cb, void* userdata,
@@ -525,6 +689,11 @@ static void innards(const uchar *buf, int X, int Y, int W, int H,
     xi.data = (char *)(buf+delta*dx+linedelta*dy);
     xi.bytes_per_line = linedelta;
 
+#if HAVE_XSHM
+  } else if (shm_innards(buf, X, Y, W, dx, dy, w, h, delta, linedelta,
+                         conv, cb, userdata, gc)) {
+    // drawn through shared memory
+#endif // HAVE_XSHM
   } else {
     int linesize = ((w*bytes_per_pixel+scanline_add)&scanline_mask)/sizeof(STORETYPE);
     int blocking = h;
@@ -843,7 +1012,7 @@ int Fl_Xlib_Graphics_Driver::scale_and_render_pixmap(Fl_Offscreen pixmap, int de
       { XDoubleToFixed( 0 ),       XDoubleToFixed( 0 ),       XDoubleToFixed( 1 ) }
     }};
     XRenderSetPictureTransform(fl_display, src, &mat);
-    if (Fl_Image::scaling_algorithm() == FL_RGB_SCALING_BILINEAR) {
+    if (Fl_Image::scaling_algorithm() != FL_RGB_SCALING_NEAREST) {
       XRenderSetPictureFilter(fl_display, src, FilterBilinear, 0, 0);
       // A note at  https://www.talisman.org/~erlkonig/misc/x11-composite-tutorial/ :
       // "When you use a filter you'll probably want to use PictOpOver as the render op,
@@ -0,0 +1,144 @@
+//
+// Pixel converter benchmark program for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// This console program checks the SIMD pixel converters used by the Xlib
+// image drawing code against plain C++ converters, then measures how many
+// pixels per second each of them converts.
+//
+// Usage: pixel_converters [width height [frames]]
+
+#include <FL/Fl.H>
+#include "../src/drivers/Xlib/Fl_Xlib_Pixel_Converters.H"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned int U32;
+
+// Plain C++ converters, same formulas as in Fl_Xlib_Graphics_Driver_image.cxx
+
+static void xrgb_plain(const uchar *from, uchar *to, int w, int delta) {
+  U32 *t = (U32 *)to;
+  for (; w--; from += delta) *t++ = (from[0] << 16) + (from[1] << 8) + from[2];
+}
+
+static void xbgr_plain(const uchar *from, uchar *to, int w, int delta) {
+  U32 *t = (U32 *)to;
+  for (; w--; from += delta) *t++ = from[0] + (from[1] << 8) + (from[2] << 16);
+}
+
+static void argb_premul_plain(const uchar *from, uchar *to, int w, int delta) {
+  U32 *t = (U32 *)to;
+  for (; w--; from += delta)
+    *t++ = (U32(from[3]) << 24) +
+           (((from[0] * from[3]) / 255) << 16) +
+           (((from[1] * from[3]) / 255) << 8) +
+           ((from[2] * from[3]) / 255);
+}
+
+typedef void (*Plain_Converter)(const uchar *from, uchar *to, int w, int delta);
+
+// Convert like the driver does: SIMD first, the remaining pixels plain
+static void convert(Fl_Xlib_Simd_Converter simd, Plain_Converter plain,
+                    const uchar *from, uchar *to, int w, int delta) {
+  if (simd) {
+    int n = simd(from, to, w, delta);
+    from += n * delta;
+    to += n * 4;
+    w -= n;
+  }
+  plain(from, to, w, delta);
+}
+
+struct Test {
+  const char *name;
+  Fl_Xlib_Simd_Converter simd;
+  Plain_Converter plain;
+  int delta;
+};
+
+// Compare SIMD and plain conversion of all widths up to 64 pixels
+static bool check(const Test &t, const uchar *src) {
+  U32 expected[64], result[64];
+  for (int w = 0; w <= 64; w++) {
+    for (int offset = 0; offset < 4; offset++) {
+      memset(expected, 0, sizeof(expected));
+      memset(result, 0, sizeof(result));
+      t.plain(src + offset, (uchar *)expected, w, t.delta);
+      convert(t.simd, t.plain, src + offset, (uchar *)result, w, t.delta);
+      if (memcmp(expected, result, sizeof(expected))) {
+        printf("%-12s delta %d: wrong result for width %d\n", t.name, t.delta, w);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Return the number of megapixels per second converted
+static double measure(Fl_Xlib_Simd_Converter simd, Plain_Converter plain, int delta,
+                      const uchar *src, uchar *dst, int W, int H, int frames) {
+  Fl_Timestamp start = Fl::now();
+  for (int f = 0; f < frames; f++)
+    for (int y = 0; y < H; y++)
+      convert(simd, plain, src + y * W * delta, dst + y * W * 4, W, delta);
+  double s = Fl::seconds_since(start);
+  return s > 0 ? double(W) * H * frames / s / 1e6 : 0;
+}
+
+int main(int argc, char **argv) {
+  int W = 1920, H = 1080, frames = 50;
+  if (argc >= 3) { W = atoi(argv[1]); H = atoi(argv[2]); }
+  if (argc >= 4) frames = atoi(argv[3]);
+  if (W < 1 || H < 1 || frames < 1) {
+    fprintf(stderr, "Usage: %s [width height [frames]]\n", argv[0]);
+    return 1;
+  }
+  Fl_Xlib_Simd_Converters simd = fl_xlib_simd_converters();
+  const Test tests[] = {
+    { "xrgb",        simd.xrgb,        xrgb_plain,        3 },
+    { "xrgb",        simd.xrgb,        xrgb_plain,        4 },
+    { "xbgr",        simd.xbgr,        xbgr_plain,        3 },
+    { "xbgr",        simd.xbgr,        xbgr_plain,        4 },
+    { "argb_premul", simd.argb_premul, argb_premul_plain, 4 }
+  };
+  const int ntests = sizeof(tests) / sizeof(tests[0]);
+
+  uchar *src = new uchar[size_t(W) * H * 4 + 256];
+  uchar *dst = new uchar[size_t(W) * H * 4];
+  srand(1);
+  for (size_t i = 0; i < size_t(W) * H * 4 + 256; i++) src[i] = uchar(rand());
+
+  int errors = 0;
+  for (int i = 0; i < ntests; i++)
+    if (!check(tests[i], src)) errors++;
+  if (!simd.xrgb) printf("No SIMD converters for this CPU.\n");
+
+  printf("%dx%d pixels, %d frames, Mpixels/s:\n", W, H, frames);
+  printf("%-12s %5s %10s %10s\n", "converter", "delta", "plain", "SIMD");
+  for (int i = 0; i < ntests; i++) {
+    const Test &t = tests[i];
+    double plain = measure(0, t.plain, t.delta, src, dst, W, H, frames);
+    printf("%-12s %5d %10.0f", t.name, t.delta, plain);
+    if (t.simd)
+      printf(" %10.0f\n", measure(t.simd, t.plain, t.delta, src, dst, W, H, frames));
+    else
+      printf(" %10s\n", "-");
+  }
+  delete[] src;
+  delete[] dst;
+  return errors ? 1 : 0;
+}
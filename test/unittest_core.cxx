@@ -18,13 +18,32 @@
 
 #include <FL/Fl_Group.H>
 #include <FL/Fl_Button.H>
+#include <FL/Fl_Browser.H>
+#include <FL/Fl_File_Browser.H>
+#include <FL/Fl_File_Icon.H>
+#include <FL/Fl_Table_Row.H>
 #include <FL/Fl_Terminal.H>
+#include <FL/Fl_Tree.H>
 #include <FL/Fl_Preferences.H>
+#include <FL/Fl_Text_Buffer.H>
+#include <FL/Fl_Shared_Image.H>
+#include <FL/Fl_JPEG_Image.H>
+#include <FL/Fl_PNG_Image.H>
+#include <FL/Fl_Device.H>
+#include <FL/Fl_Graphics_Driver.H>
 #include <FL/fl_callback_macros.H>
 #include <FL/filename.H>
 #include <FL/fl_utf8.h>
+#ifndef FL_DLL                  // internal classes are not exported from the DLL
+#include "../src/Fl_Text_Wrap_Cache.H"
+#endif
 
 #include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 
 /* Test additions to Fl_Preferences. */
@@ -50,6 +69,1237 @@ TEST(Fl_Preferences, Strings) {
   return true;
 }
 
+/* Test that both text buffer storage engines hold the same text after
+   a series of edits at varying positions. */
+TEST(Fl_Text_Buffer, Storage) {
+  Fl_Text_Buffer gap;
+  Fl_Text_Buffer pieces(0, 1024, Fl_Text_Buffer::PIECE_TABLE);
+  EXPECT_EQ(pieces.storage(), Fl_Text_Buffer::PIECE_TABLE);
+  unsigned seed = 1;
+  for (int i = 0; i < 2000; i++) {
+    seed = seed * 1103515245 + 12345;
+    int pos = gap.length() ? (int)((seed >> 8) % (unsigned)gap.length()) : 0;
+    if ((seed >> 4) % 3) {
+      const char *text = ((seed >> 6) & 1) ? "line\n" : "w\xc3\xb6rd ";
+      gap.insert(pos, text);
+      pieces.insert(pos, text);
+    } else {
+      int end = pos + (int)((seed >> 12) % 20);
+      end = gap.utf8_align(end < gap.length() ? end : gap.length());
+      pos = gap.utf8_align(pos);
+      gap.remove(pos, end);
+      pieces.remove(pos, end);
+    }
+  }
+  std::string a = gap.text_str(), b = pieces.text_str();
+  EXPECT_STREQ(a.c_str(), b.c_str());
+  EXPECT_EQ(pieces.count_lines(0, pieces.length()), gap.count_lines(0, gap.length()));
+  EXPECT_EQ(pieces.skip_lines(0, 50), gap.skip_lines(0, 50));
+  EXPECT_EQ(pieces.rewind_lines(pieces.length(), 50), gap.rewind_lines(gap.length(), 50));
+  EXPECT_EQ(pieces.line_start(pieces.length() / 2), gap.line_start(gap.length() / 2));
+  int found_gap = -1, found_pieces = -1;
+  gap.search_forward(0, "line\nw", &found_gap);
+  pieces.search_forward(0, "line\nw", &found_pieces);
+  EXPECT_EQ(found_pieces, found_gap);
+  pieces.undo();
+  gap.undo();
+  a = gap.text_str();
+  b = pieces.text_str();
+  EXPECT_STREQ(a.c_str(), b.c_str());
+  return true;
+}
+
+/* Test that the line index gives the same results as scanning the text. */
+TEST(Fl_Text_Buffer, line_index) {
+  Fl_Text_Buffer plain;
+  Fl_Text_Buffer indexed(0, 1024, Fl_Text_Buffer::PIECE_TABLE);
+  indexed.line_index(true);
+  EXPECT_TRUE(indexed.line_index());
+  unsigned seed = 7;
+  for (int i = 0; i < 3000; i++) {
+    seed = seed * 1103515245 + 12345;
+    int pos = plain.length() ? (int)((seed >> 8) % (unsigned)plain.length()) : 0;
+    if ((seed >> 4) % 4) {
+      const char *text = ((seed >> 6) & 1) ? "\n" : "some text\nand more text ";
+      plain.insert(pos, text);
+      indexed.insert(pos, text);
+    } else {
+      int end = pos + (int)((seed >> 12) % 5000);
+      plain.remove(pos, end);
+      indexed.remove(pos, end);
+    }
+    int a = (int)((seed >> 3) % (unsigned)(plain.length() + 1));
+    int b = (int)((seed >> 9) % (unsigned)(plain.length() + 1));
+    int n = (int)((seed >> 16) % 40);
+    EXPECT_EQ(indexed.count_lines(a, b), plain.count_lines(a, b));
+    EXPECT_EQ(indexed.skip_lines(a, n), plain.skip_lines(a, n));
+    EXPECT_EQ(indexed.rewind_lines(b, n), plain.rewind_lines(b, n));
+    EXPECT_EQ(indexed.line_start(a), plain.line_start(a));
+    EXPECT_EQ(indexed.line_end(b), plain.line_end(b));
+  }
+  indexed.text("one\ntwo\nthree");
+  EXPECT_EQ(indexed.count_lines(0, indexed.length()), 2);
+  EXPECT_EQ(indexed.skip_lines(0, 2), 8);
+  return true;
+}
+
+/* Test loading a file by mapping it into memory. */
+TEST(Fl_Text_Buffer, mapfile) {
+  char path[FL_PATH_MAX];
+  Fl_Preferences prefs(Fl_Preferences::USER_L, "fltk.org", "unittests");
+  EXPECT_TRUE(prefs.get_userdata_path(path, sizeof(path)) != 0);
+  std::string file = std::string(path) + "mapfile.txt";
+  Fl_Text_Buffer gap;
+  for (int i = 0; i < 1000; i++)
+    gap.printf("Line %d of the mapped file\n", i);
+  EXPECT_EQ(gap.savefile(file.c_str()), 0);
+  {
+    Fl_Text_Buffer pieces(0, 1024, Fl_Text_Buffer::PIECE_TABLE);
+    EXPECT_EQ(pieces.mapfile(file.c_str()), 0);
+    EXPECT_EQ(pieces.length(), gap.length());
+    EXPECT_EQ(pieces.count_lines(0, pieces.length()), 1000);
+    pieces.insert(pieces.skip_lines(0, 500), "inserted\n");
+    gap.insert(gap.skip_lines(0, 500), "inserted\n");
+    pieces.remove(10, 20);
+    gap.remove(10, 20);
+    std::string a = gap.text_str(), b = pieces.text_str();
+    EXPECT_STREQ(a.c_str(), b.c_str());
+  }
+  fl_unlink(file.c_str());
+  return true;
+}
+
+#ifndef FL_DLL
+
+// Return 1 if the blocks cover the whole buffer and end after a newline.
+static int ut_blocks_valid(Fl_Text_Wrap_Cache &cache, Fl_Text_Buffer &buf) {
+  int pos = 0;
+  for (int i = 0; i < cache.blocks(); i++) {
+    if (cache.start(i) != pos || cache.bytes(i) <= 0) return 0;
+    pos = cache.end(i);
+    if (i < cache.blocks() - 1 && buf.byte_at(pos - 1) != '\n') return 0;
+  }
+  return pos == buf.length();
+}
+
+/* Test splitting a buffer into blocks, and updating them after changes. */
+TEST(Fl_Text_Wrap_Cache, blocks) {
+  const int block_size = Fl_Text_Wrap_Cache::block_size;
+  Fl_Text_Buffer buf;
+  for (int i = 0; i < 5000; i++)
+    buf.append("0123456789012345678\n");      // 20 bytes per line
+  Fl_Text_Wrap_Cache cache;
+  cache.build(&buf);
+  EXPECT_TRUE(cache.built());
+  EXPECT_TRUE(ut_blocks_valid(cache, buf));
+  int n = cache.blocks();
+  EXPECT_EQ(n, 6);                              // the last one gets the rest
+  EXPECT_EQ(cache.bytes(0), 16400);             // extended to the line end
+  EXPECT_EQ(cache.find(cache.start(2)), 2);
+  EXPECT_EQ(cache.find(cache.start(2) - 1), 1);
+  EXPECT_EQ(cache.find(buf.length() + 10), n - 1);
+  for (int i = 0; i < n; i++)
+    cache.lines(i, 100, true);
+
+  // modify: only the changed block forgets its line count
+  int pos = cache.start(2) + 100;
+  buf.insert(pos, "new line\n");
+  cache.modified(&buf, pos, 9, 0);
+  EXPECT_TRUE(ut_blocks_valid(cache, buf));
+  EXPECT_EQ(cache.blocks(), n);
+  EXPECT_EQ(cache.lines(1), 100);
+  EXPECT_EQ(cache.lines(2), -1);
+  EXPECT_EQ(cache.lines(3), 100);
+
+  // split: a block that grew a lot is divided again
+  std::string big;
+  for (int i = 0; i < 2000; i++)
+    big += "abcdefghi\n";
+  pos = cache.start(3);
+  buf.insert(pos, big.c_str());
+  cache.modified(&buf, pos, (int)big.size(), 0);
+  EXPECT_TRUE(ut_blocks_valid(cache, buf));
+  EXPECT_EQ(cache.blocks(), n + 1);
+  EXPECT_EQ(cache.lines(4), -1);
+  n = cache.blocks();
+
+  // merge: a block that shrank a lot is merged with its neighbor
+  int s = cache.start(1), e = cache.end(1) - 100;
+  buf.remove(s, e);
+  cache.modified(&buf, s, 0, e - s);
+  EXPECT_TRUE(ut_blocks_valid(cache, buf));
+  EXPECT_EQ(cache.blocks(), n - 1);
+  int small = 0;
+  for (int i = 0; i < cache.blocks() - 1; i++) {
+    if (cache.bytes(i) < block_size / 2) small++;
+  }
+  EXPECT_EQ(small, 0);
+
+  // invalidate: restyled blocks forget their line count
+  n = cache.blocks();
+  for (int i = 0; i < n; i++)
+    cache.lines(i, 100, true);
+  cache.invalidate(cache.start(2) + 5, cache.start(3) + 5);
+  EXPECT_EQ(cache.lines(1), 100);
+  EXPECT_EQ(cache.lines(2), -1);
+  EXPECT_EQ(cache.lines(3), -1);
+  EXPECT_EQ(cache.lines(4), 100);
+  EXPECT_TRUE(cache.exact(4));
+
+  // a change of the layout forgets all line counts, but not the blocks
+  cache.layout(200, FL_COURIER, 12, 0, 0);
+  EXPECT_EQ(cache.lines(4), -1);
+  EXPECT_EQ(cache.blocks(), n);
+  return true;
+}
+
+#endif // FL_DLL
+
+/* Test adding, finding, and releasing many shared images. */
+TEST(Fl_Shared_Image, pool) {
+  static uchar pixels[4 * 4 * 3];
+  const int n = 500;
+  int base = Fl_Shared_Image::num_images();
+  Fl_Shared_Image *img[n];
+  for (int i = 0; i < n; i++)
+    img[i] = Fl_Shared_Image::get(new Fl_RGB_Image(pixels, 4, 4, 3));
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base + n);
+  for (int i = 0; i < n; i += 7) {
+    Fl_Shared_Image *found = Fl_Shared_Image::find(img[i]->name());
+    EXPECT_TRUE(found == img[i]);
+    found->release();
+    found = Fl_Shared_Image::find(img[i]->name(), 4, 4);
+    EXPECT_TRUE(found == img[i]);
+    found->release();
+    EXPECT_TRUE(Fl_Shared_Image::find(img[i]->name(), 8, 8) == NULL);
+  }
+  // a resized copy is added to the pool and references the original
+  Fl_Shared_Image *big = (Fl_Shared_Image *)img[3]->copy(8, 8);
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base + n + 1);
+  EXPECT_TRUE(Fl_Shared_Image::find(img[3]->name(), 8, 8) == big);
+  big->release();
+  EXPECT_EQ(big->refcount(), 1);
+  Fl_Shared_Image **list = Fl_Shared_Image::images();
+  int sorted = 1;
+  for (int i = 1; i < Fl_Shared_Image::num_images(); i++)
+    if (strcmp(list[i-1]->name(), list[i]->name()) > 0) sorted = 0;
+  EXPECT_TRUE(sorted);
+  big->release();
+  for (int i = 0; i < n; i += 2)
+    img[i]->release();
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base + n / 2);
+  for (int i = 1; i < n; i += 2) {
+    Fl_Shared_Image *found = Fl_Shared_Image::find(img[i]->name());
+    EXPECT_TRUE(found == img[i]);
+    found->release();
+    img[i]->release();
+  }
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base);
+  return true;
+}
+
+// A shared image with a name chosen by the test, like an image file
+class Ut_Named_Image : public Fl_Shared_Image {
+  Ut_Named_Image(const char *name, Fl_Image *img) : Fl_Shared_Image(name, img) {
+    alloc_image_ = 1;
+  }
+public:
+  static Fl_Shared_Image *get(const char *name, Fl_Image *img) {
+    Fl_Shared_Image *shared = find(name);
+    if (shared) {
+      delete img;
+      return shared;
+    }
+    shared = new Ut_Named_Image(name, img);
+    ((Ut_Named_Image *)shared)->add();
+    return shared;
+  }
+};
+
+/* Test keeping unused shared images in the cache. */
+TEST(Fl_Shared_Image, cache_size) {
+  static uchar pixels[4 * 4 * 3];
+  const int n = 20;
+  int base = Fl_Shared_Image::num_images();
+  size_t used = Fl_Shared_Image::cache_used();
+  Fl_Shared_Image::cache_size(used + 10 * sizeof(pixels));
+  char names[n][32];
+  for (int i = 0; i < n; i++) {
+    snprintf(names[i], sizeof(names[i]), "ut_cache_%d", i);
+    Ut_Named_Image::get(names[i], new Fl_RGB_Image(pixels, 4, 4, 3))->release();
+  }
+  // only the 10 most recently used images are kept
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base + 10);
+  EXPECT_TRUE(Fl_Shared_Image::find(names[5]) == NULL);
+  Fl_Shared_Image *img = Fl_Shared_Image::find(names[15]);
+  EXPECT_TRUE(img != NULL);
+  EXPECT_EQ(img->refcount(), 1);
+  // setting the size to 0 deletes all unused images
+  Fl_Shared_Image::cache_size(0);
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base + 1);
+  img->release();
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base);
+  // images with a generated name are not kept in the cache, whether
+  // they own their data or not
+  Fl_Shared_Image::cache_size(100 * sizeof(pixels));
+  Fl_RGB_Image *rgb = new Fl_RGB_Image(pixels, 4, 4, 3);
+  img = Fl_Shared_Image::get(rgb, 0);
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base + 1);
+  img->release();
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base);
+  delete rgb;
+  img = Fl_Shared_Image::get(new Fl_RGB_Image(pixels, 4, 4, 3), 1);
+  img->release();
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base);
+  EXPECT_TRUE(Fl_Shared_Image::cache_used() == used);
+  Fl_Shared_Image::cache_size(0);
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base);
+  return true;
+}
+
+/* Test loading a shared image without blocking. */
+TEST(Fl_Shared_Image, get_async) {
+  char path[FL_PATH_MAX];
+  Fl_Preferences prefs(Fl_Preferences::USER_L, "fltk.org", "unittests");
+  EXPECT_TRUE(prefs.get_userdata_path(path, sizeof(path)) != 0);
+  std::string file = std::string(path) + "get_async.xbm";
+  FILE *f = fl_fopen(file.c_str(), "wb");
+  EXPECT_TRUE(f != NULL);
+  fputs("#define t_width 8\n#define t_height 2\n"
+        "static unsigned char t_bits[] = { 0x0f, 0xf0 };\n", f);
+  fclose(f);
+  int base = Fl_Shared_Image::num_images();
+  Fl_Shared_Image *img = Fl_Shared_Image::get_async(file.c_str());
+  EXPECT_TRUE(img != NULL);
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base + 1);
+  EXPECT_TRUE(img->image() == NULL);
+  // a second request returns the same placeholder
+  Fl_Shared_Image *img2 = Fl_Shared_Image::get_async(file.c_str());
+  EXPECT_TRUE(img2 == img);
+  img2->release();
+  for (int i = 0; i < 100 && !img->image(); i++)
+    Fl::wait(0.01);
+  EXPECT_TRUE(img->image() != NULL);
+  EXPECT_EQ(img->w(), 8);
+  EXPECT_EQ(img->h(), 2);
+  Fl_Shared_Image *found = Fl_Shared_Image::find(file.c_str(), 8, 2);
+  EXPECT_TRUE(found == img);
+  found->release();
+  img->release();
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base);
+  fl_unlink(file.c_str());
+  return true;
+}
+
+/* Test get_async() with a resized image, loaded in a background thread. */
+TEST(Fl_Shared_Image, get_async_resized) {
+  char path[FL_PATH_MAX];
+  Fl_Preferences prefs(Fl_Preferences::USER_L, "fltk.org", "unittests");
+  EXPECT_TRUE(prefs.get_userdata_path(path, sizeof(path)) != 0);
+  std::string file = std::string(path) + "get_async_resized.xbm";
+  FILE *f = fl_fopen(file.c_str(), "wb");
+  EXPECT_TRUE(f != NULL);
+  fputs("#define t_width 8\n#define t_height 2\n"
+        "static unsigned char t_bits[] = { 0x0f, 0xf0 };\n", f);
+  fclose(f);
+  Fl::lock();                   // enable background threads
+  int base = Fl_Shared_Image::num_images();
+  Fl_Shared_Image *img = Fl_Shared_Image::get_async(file.c_str(), 16, 4);
+  EXPECT_TRUE(img != NULL);
+  EXPECT_TRUE(img->image() == NULL);
+  EXPECT_EQ(img->w(), 16);
+  EXPECT_EQ(img->h(), 4);
+  // the placeholder of the original is in the pool as well
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base + 2);
+  Fl_Shared_Image *orig = Fl_Shared_Image::get_async(file.c_str());
+  EXPECT_TRUE(orig != img);
+  EXPECT_EQ(orig->w(), 0);
+  for (int i = 0; i < 100 && !img->image(); i++)
+    Fl::wait(0.01);
+  EXPECT_TRUE(img->image() != NULL);
+  EXPECT_EQ(img->data_w(), 16);
+  EXPECT_EQ(img->data_h(), 4);
+  // the original was not resized
+  EXPECT_EQ(orig->w(), 8);
+  EXPECT_EQ(orig->h(), 2);
+  Fl_Shared_Image *found = Fl_Shared_Image::find(file.c_str(), 16, 4);
+  EXPECT_TRUE(found == img);
+  found->release();
+  img->release();
+  orig->release();
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base);
+
+  // get() loads an image that is still loading, it never returns a placeholder
+  img = Fl_Shared_Image::get_async(file.c_str());
+  Fl_Shared_Image *now = Fl_Shared_Image::get(file.c_str(), 4, 1);
+  EXPECT_TRUE(now != NULL);
+  EXPECT_TRUE(now->image() != NULL);
+  EXPECT_EQ(now->data_w(), 4);
+  EXPECT_TRUE(img->image() != NULL);
+  now->release();
+  for (int i = 0; i < 10; i++)  // let the background thread finish
+    Fl::wait(0.01);
+  img->release();
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base);
+  Fl::unlock();
+  fl_unlink(file.c_str());
+  return true;
+}
+
+/* Test get_async() with an image that can't be loaded. */
+TEST(Fl_Shared_Image, get_async_failed) {
+  char path[FL_PATH_MAX];
+  Fl_Preferences prefs(Fl_Preferences::USER_L, "fltk.org", "unittests");
+  EXPECT_TRUE(prefs.get_userdata_path(path, sizeof(path)) != 0);
+  std::string file = std::string(path) + "get_async_missing.xbm";
+  fl_unlink(file.c_str());
+  int base = Fl_Shared_Image::num_images();
+  Fl_Shared_Image *img = Fl_Shared_Image::get_async(file.c_str());
+  Fl_Shared_Image *copy = Fl_Shared_Image::get_async(file.c_str(), 10, 10);
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base + 2);
+  for (int i = 0; i < 100 && Fl_Shared_Image::num_images() > base; i++)
+    Fl::wait(0.01);
+  // the placeholders are no longer in the pool, but still valid
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base);
+  EXPECT_TRUE(img->image() == NULL);
+  EXPECT_TRUE(copy->image() == NULL);
+  EXPECT_TRUE(Fl_Shared_Image::find(file.c_str()) == NULL);
+  EXPECT_TRUE(Fl_Shared_Image::get(file.c_str()) == NULL);
+  copy->release();
+  img->release();
+  EXPECT_EQ(Fl_Shared_Image::num_images(), base);
+  return true;
+}
+
+/* Test decoding reduced size JPEG images. */
+TEST(Fl_JPEG_Image, reduced_size) {
+  char path[FL_PATH_MAX];
+  Fl_Preferences prefs(Fl_Preferences::USER_L, "fltk.org", "unittests");
+  EXPECT_TRUE(prefs.get_userdata_path(path, sizeof(path)) != 0);
+  std::string file = std::string(path) + "reduced_size.jpg";
+  std::vector<uchar> pixels(64 * 48 * 3);
+  for (size_t i = 0; i < pixels.size(); i += 3) {
+    pixels[i] = 200; pixels[i + 1] = 100; pixels[i + 2] = 50;
+  }
+  if (fl_write_jpeg(file.c_str(), &pixels[0], 64, 48) != 0)
+    return true;  // no JPEG support
+  Fl_JPEG_Image full(file.c_str());
+  EXPECT_EQ(full.w(), 64);
+  EXPECT_EQ(full.h(), 48);
+  // the smallest scale of 1/2, 1/4, 1/8 that is at least the requested size
+  Fl_JPEG_Image quarter(file.c_str(), 16, 10);
+  EXPECT_EQ(quarter.w(), 16);
+  EXPECT_EQ(quarter.h(), 12);
+  Fl_JPEG_Image half(file.c_str(), 20, 20);
+  EXPECT_EQ(half.w(), 32);
+  EXPECT_EQ(half.h(), 24);
+  Fl_JPEG_Image eighth(file.c_str(), 1, 1);
+  EXPECT_EQ(eighth.w(), 8);
+  EXPECT_EQ(eighth.h(), 6);
+  EXPECT_TRUE(abs(eighth.array[0] - 200) < 8);
+  EXPECT_TRUE(abs(eighth.array[1] - 100) < 8);
+  EXPECT_TRUE(abs(eighth.array[2] - 50) < 8);
+  Fl_JPEG_Image same(file.c_str(), 64, 48);
+  EXPECT_EQ(same.w(), 64);
+  fl_unlink(file.c_str());
+  return true;
+}
+
+struct Ut_Progress {
+  int calls, y1;
+  bool preview;
+};
+
+static void ut_progress_cb(Fl_Progressive_Image *img, int y, int h, void *data) {
+  Ut_Progress *p = (Ut_Progress *)data;
+  // the first pass of an interlaced image fills the whole image
+  if (p->calls++ == 0)
+    p->preview = memcmp(img->array, img->array + (img->w() * img->h() - 1) * img->d(), img->d()) == 0;
+  if (y + h > p->y1) p->y1 = y + h;
+}
+
+/* Test decoding a PNG image while its data arrives. */
+TEST(Fl_Progressive_Image, png) {
+  // 8x8 Adam7 interlaced RGB image, pixel x, y is (32 * x, 32 * y, 200)
+  static const uchar png[] = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d,
+    0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x08,
+    0x08, 0x02, 0x00, 0x00, 0x01, 0x3c, 0x6a, 0x19, 0x4a, 0x00, 0x00, 0x00,
+    0x73, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x0d, 0x8c, 0x31, 0x11, 0x00,
+    0x40, 0x0c, 0xc2, 0x2a, 0x05, 0x29, 0x95, 0x82, 0x94, 0x4a, 0x41, 0x4a,
+    0xc7, 0xc8, 0xa8, 0x94, 0xff, 0x81, 0x21, 0x17, 0xa0, 0xaa, 0xa8, 0xf9,
+    0xa9, 0x61, 0x86, 0xea, 0x62, 0x3f, 0xf5, 0xb0, 0x9f, 0xaa, 0xe9, 0x66,
+    0x9a, 0xed, 0x0f, 0x4b, 0x2f, 0xb3, 0xec, 0x52, 0x2a, 0x5c, 0xa4, 0xb8,
+    0xdf, 0x56, 0xe3, 0x26, 0xcd, 0xfd, 0x9a, 0x06, 0x0f, 0x19, 0xee, 0x1f,
+    0x68, 0xf1, 0x92, 0xe5, 0xfe, 0xa6, 0x84, 0x44, 0x0b, 0x8b, 0x11, 0x11,
+    0x2b, 0x4e, 0x5f, 0x18, 0x99, 0x36, 0x36, 0x63, 0x62, 0xd6, 0x9c, 0xbf,
+    0x08, 0x0a, 0x1d, 0x1c, 0x26, 0x24, 0x6c, 0xb8, 0x7c, 0x71, 0xe8, 0xe8,
+    0xc3, 0xc7, 0x1c, 0x39, 0xf6, 0xb8, 0xe3, 0x01, 0x02, 0xa0, 0x6a, 0x01,
+    0xbd, 0xdb, 0x18, 0x56, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44,
+    0xae, 0x42, 0x60, 0x82 };
+  Fl_Progressive_PNG_Image img;
+  if (img.fail()) return true;  // no PNG support
+  Ut_Progress progress = { 0, 0, false };
+  img.handler(ut_progress_cb, &progress);
+  int err = 0;
+  for (size_t i = 0; i < sizeof(png); i++)
+    err |= img.write(png + i, 1);
+  EXPECT_EQ(err, 0);
+  EXPECT_TRUE(img.complete());
+  EXPECT_EQ(img.w(), 8);
+  EXPECT_EQ(img.h(), 8);
+  EXPECT_EQ(img.d(), 3);
+  EXPECT_TRUE(progress.calls >= 7);
+  EXPECT_TRUE(progress.preview);
+  EXPECT_EQ(progress.y1, 8);
+  bool same = true;
+  for (int y = 0; y < 8; y++)
+    for (int x = 0; x < 8; x++) {
+      const uchar *p = img.array + (y * 8 + x) * 3;
+      if (p[0] != 32 * x || p[1] != 32 * y || p[2] != 200) same = false;
+    }
+  EXPECT_TRUE(same);
+  // invalid data
+  Fl_Progressive_PNG_Image bad;
+  EXPECT_EQ(bad.write(png + 1, 20), -1);
+  EXPECT_EQ(bad.fail(), Fl_Image::ERR_FORMAT);
+  return true;
+}
+
+/* Test decoding a JPEG image while its data arrives. */
+TEST(Fl_Progressive_Image, jpeg) {
+  char path[FL_PATH_MAX];
+  Fl_Preferences prefs(Fl_Preferences::USER_L, "fltk.org", "unittests");
+  EXPECT_TRUE(prefs.get_userdata_path(path, sizeof(path)) != 0);
+  std::string file = std::string(path) + "progressive.jpg";
+  std::vector<uchar> pixels(64 * 48 * 3);
+  for (size_t i = 0; i < pixels.size(); i++)
+    pixels[i] = uchar(i * 7 / 3);
+  if (fl_write_jpeg(file.c_str(), &pixels[0], 64, 48) != 0)
+    return true;  // no JPEG support
+  FILE *f = fl_fopen(file.c_str(), "rb");
+  EXPECT_TRUE(f != NULL);
+  std::vector<uchar> data(100000);
+  data.resize(fread(&data[0], 1, data.size(), f));
+  fclose(f);
+  Fl_JPEG_Image full(file.c_str());
+  fl_unlink(file.c_str());
+  Fl_Progressive_JPEG_Image img;
+  Ut_Progress progress = { 0, 0, false };
+  img.handler(ut_progress_cb, &progress);
+  int err = 0;
+  for (size_t i = 0; i < data.size(); i += 100)
+    err |= img.write(&data[i], data.size() - i < 100 ? data.size() - i : 100);
+  EXPECT_EQ(err, 0);
+  EXPECT_TRUE(img.complete());
+  EXPECT_EQ(img.w(), 64);
+  EXPECT_EQ(img.h(), 48);
+  EXPECT_TRUE(progress.calls > 1);
+  EXPECT_EQ(progress.y1, 48);
+  EXPECT_TRUE(memcmp(img.array, full.array, 64 * 48 * 3) == 0);
+  return true;
+}
+
+/* Test copying RGB images with FL_RGB_SCALING_AREA. */
+TEST(Fl_RGB_Image, area_scaling) {
+  Fl_RGB_Scaling old = Fl_Image::RGB_scaling();
+  Fl_Image::RGB_scaling(FL_RGB_SCALING_AREA);
+  // every pixel of the copy is the average of the pixels it covers
+  static const uchar rgb[4 * 2 * 3] = {
+    0, 0, 0,   100, 10, 200,   50, 50, 50,   50, 50, 50,
+    0, 0, 0,   100, 10, 200,   10, 20, 30,   30, 20, 10 };
+  Fl_RGB_Image src(rgb, 4, 2, 3);
+  Fl_RGB_Image *img = (Fl_RGB_Image *)src.copy(2, 1);
+  const uchar *p = img->array;
+  EXPECT_EQ(p[0], 50);
+  EXPECT_EQ(p[1], 5);
+  EXPECT_EQ(p[2], 100);
+  EXPECT_EQ(p[3], 35);
+  EXPECT_EQ(p[4], 35);
+  EXPECT_EQ(p[5], 35);
+  img->release();
+  // transparent pixels don't change the color
+  static const uchar rgba[3 * 4] = { 200, 0, 0, 255,   0, 0, 255, 0,   100, 0, 0, 255 };
+  Fl_RGB_Image src4(rgba, 3, 1, 4);
+  img = (Fl_RGB_Image *)src4.copy(1, 1);
+  p = img->array;
+  EXPECT_EQ(p[0], 150);
+  EXPECT_EQ(p[2], 0);
+  EXPECT_EQ(p[3], 170);
+  img->release();
+  // scaling up keeps the corner pixels
+  img = (Fl_RGB_Image *)src.copy(9, 5);
+  p = img->array;
+  EXPECT_EQ(p[0], 0);
+  EXPECT_EQ(p[(4 * 9 + 8) * 3 + 2], 10);
+  img->release();
+  // large images (scaled by several threads) keep a constant color
+  std::vector<uchar> big(1500 * 1000 * 2);
+  for (size_t i = 0; i < big.size(); i += 2) { big[i] = 77; big[i + 1] = 255; }
+  Fl_RGB_Image src2(&big[0], 1500, 1000, 2);
+  img = (Fl_RGB_Image *)src2.copy(333, 77);
+  bool same = true;
+  for (int i = 0; i < 333 * 77 * 2; i += 2)
+    if (img->array[i] != 77 || img->array[i + 1] != 255) same = false;
+  EXPECT_TRUE(same);
+  img->release();
+  Fl_Image::RGB_scaling(old);
+  return true;
+}
+
+static void awake_count_cb(void *data) {
+  (*(int*)data)++;
+}
+
+static void awake_producer(int *n) {
+  for (int i = 0; i < 2000; i++) {
+    Fl::awake(awake_count_cb, n);
+    if (i % 64 == 0) std::this_thread::yield();
+  }
+}
+
+/* Test that no awake handler of several threads is lost. */
+TEST(Fl, awake_threads) {
+  int n = 0;
+  EXPECT_EQ(Fl::lock(), 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+    threads.push_back(std::thread(awake_producer, &n));
+  // handle the handlers while they are added
+  for (int i = 0; i < 1000 && n < 8000; i++)
+    Fl::wait(0.01);
+  for (size_t t = 0; t < threads.size(); t++)
+    threads[t].join();
+  for (int i = 0; i < 100 && n < 8000; i++)
+    Fl::wait(0.01);
+  EXPECT_EQ(n, 8000);
+  Fl::unlock();
+  return true;
+}
+
+/* Test that awake handlers are neither lost nor called twice. */
+TEST(Fl, awake) {
+  int n = 0, once = 0;
+  EXPECT_EQ(Fl::lock(), 0);
+  for (int i = 0; i < 5000; i++) {
+    EXPECT_EQ(Fl::awake(awake_count_cb, &n), 0);
+    EXPECT_EQ(Fl::awake_once(awake_count_cb, &once), 0);
+  }
+  for (int i = 0; i < 100 && n < 5000; i++)
+    Fl::wait(0.01);
+  EXPECT_EQ(n, 5000);
+  EXPECT_EQ(once, 1);
+  // the handler can be scheduled again after it was called
+  EXPECT_EQ(Fl::awake_once(awake_count_cb, &once), 0);
+  for (int i = 0; i < 100 && once < 2; i++)
+    Fl::wait(0.01);
+  EXPECT_EQ(once, 2);
+  Fl::unlock();
+  return true;
+}
+
+static int timeout_log[8], timeout_count = 0;
+
+static void timeout_log_cb(void *data) {
+  timeout_log[timeout_count++ & 7] = fl_int(data);
+  if (fl_int(data) == 1)    // not called by the same Fl::wait() (issue #450)
+    Fl::add_timeout(0.0, timeout_log_cb, fl_voidptr(4));
+}
+
+/* Test the order of timeouts and finding and removing them. */
+TEST(Fl, timeout) {
+  Fl::add_timeout(0.02, timeout_log_cb, fl_voidptr(3));
+  Fl::add_timeout(0.0, timeout_log_cb, fl_voidptr(1));
+  Fl::add_timeout(0.0, timeout_log_cb, fl_voidptr(2));
+  Fl::add_timeout(0.01, timeout_log_cb, fl_voidptr(5));
+  Fl::add_timeout(0.01, timeout_log_cb, fl_voidptr(5));
+  EXPECT_EQ(Fl::has_timeout(timeout_log_cb, fl_voidptr(5)), 1);
+  EXPECT_EQ(Fl::has_timeout(timeout_log_cb, fl_voidptr(6)), 0);
+  void *data = 0;
+  EXPECT_EQ(Fl::remove_next_timeout(timeout_log_cb, fl_voidptr(5), &data), 2);
+  EXPECT_EQ(fl_int(data), 5);
+  Fl::remove_timeout(timeout_log_cb, fl_voidptr(5));
+  EXPECT_EQ(Fl::has_timeout(timeout_log_cb, fl_voidptr(5)), 0);
+  std::vector<Fl::TimeoutData> list = Fl::timeout_list();
+  EXPECT_EQ((int)list.size(), 3);
+  EXPECT_EQ(fl_int(list[0].data), 1);
+  EXPECT_EQ(fl_int(list[2].data), 3);
+  Fl::wait(0.0);
+  EXPECT_EQ(timeout_count, 2);
+  EXPECT_EQ(Fl::has_timeout(timeout_log_cb, fl_voidptr(4)), 1);
+  for (int i = 0; i < 100 && timeout_count < 4; i++)
+    Fl::wait(0.01);
+  EXPECT_EQ(timeout_count, 4);
+  EXPECT_EQ(timeout_log[0], 1);
+  EXPECT_EQ(timeout_log[1], 2);
+  EXPECT_EQ(timeout_log[2], 4);
+  EXPECT_EQ(timeout_log[3], 3);
+  Fl::add_timeout(1.0, timeout_log_cb, fl_voidptr(6));
+  Fl::add_timeout(1.0, timeout_log_cb, fl_voidptr(7));
+  Fl::remove_timeout(timeout_log_cb);
+  EXPECT_EQ((int)Fl::timeout_list().size(), 0);
+  return true;
+}
+
+#ifndef _WIN32
+
+static int fd_read_count = 0;
+
+static void fd_read_cb(int fd, void *) {
+  char c;
+  if (read(fd, &c, 1) == 1)
+    fd_read_count++;
+}
+
+// Remove the descriptor and add it again inside its own callback
+static void fd_readd_cb(int fd, void *data) {
+  Fl::remove_fd(fd);
+  Fl::add_fd(fd, FL_READ, fd_read_cb, data);
+  fd_read_cb(fd, data);
+}
+
+/* Test that Fl::add_fd() callbacks are called until Fl::remove_fd(). */
+TEST(Fl, add_fd) {
+  int p[2];
+  char c;
+  EXPECT_EQ(pipe(p), 0);
+  fd_read_count = 0;
+  Fl::add_fd(p[0], FL_READ, fd_read_cb);
+  EXPECT_EQ((int)write(p[1], "a", 1), 1);
+  for (int i = 0; i < 100 && fd_read_count < 1; i++)
+    Fl::wait(0.01);
+  EXPECT_EQ(fd_read_count, 1);
+  // no more data, no more calls
+  Fl::wait(0.01);
+  EXPECT_EQ(fd_read_count, 1);
+  // a removed descriptor is not watched any more
+  Fl::remove_fd(p[0]);
+  EXPECT_EQ((int)write(p[1], "b", 1), 1);
+  for (int i = 0; i < 5; i++)
+    Fl::wait(0.01);
+  EXPECT_EQ(fd_read_count, 1);
+  EXPECT_EQ((int)read(p[0], &c, 1), 1);
+  // the callback can remove and add its descriptor again
+  Fl::add_fd(p[0], FL_READ, fd_readd_cb);
+  EXPECT_EQ((int)write(p[1], "c", 1), 1);
+  for (int i = 0; i < 100 && fd_read_count < 2; i++)
+    Fl::wait(0.01);
+  EXPECT_EQ(fd_read_count, 2);
+  EXPECT_EQ((int)write(p[1], "d", 1), 1);
+  for (int i = 0; i < 100 && fd_read_count < 3; i++)
+    Fl::wait(0.01);
+  EXPECT_EQ(fd_read_count, 3);
+  Fl::remove_fd(p[0]);
+  EXPECT_EQ((int)write(p[1], "e", 1), 1);
+  for (int i = 0; i < 5; i++)
+    Fl::wait(0.01);
+  EXPECT_EQ(fd_read_count, 3);
+  close(p[0]);
+  close(p[1]);
+  return true;
+}
+
+#endif // !_WIN32
+
+class Ut_Size_Table : public Fl_Table {
+public:
+  Ut_Size_Table() : Fl_Table(0, 0, 200, 200) { end(); }
+  using Fl_Table::row_scroll_position;
+  using Fl_Table::col_scroll_position;
+  using Fl_Table::find_cell;
+  long long height() const { return table_h; }
+  int top() const { return toprow; }
+  int bottom() const { return botrow; }
+  double scrollbar_max() const { return vscrollbar->maximum(); }
+};
+
+/* Test row and column scroll positions with varying sizes. */
+TEST(Fl_Table, scroll_position) {
+  Ut_Size_Table table;
+  table.rows(1000);
+  table.cols(10);
+  table.row_height_all(20);
+  EXPECT_EQ(table.height(), 20000);
+  table.row_height(10, 50);
+  table.row_height(500, 0);
+  long sum = 0;
+  int same = 1;
+  for (int r = 0; r <= 1000; r++) {
+    if (table.row_scroll_position(r) != sum) same = 0;
+    sum += table.row_height(r);
+  }
+  EXPECT_TRUE(same);
+  EXPECT_EQ(table.height(), 20010);
+  EXPECT_EQ(table.col_scroll_position(10), 800);
+  table.row_position(600);
+  EXPECT_EQ(table.top(), 600);
+  EXPECT_EQ(table.row_position(), 600);
+  EXPECT_TRUE(table.bottom() > 600 && table.bottom() < 620);
+  table.rows(100);
+  EXPECT_EQ(table.height(), 2030);
+  table.rows(200);
+  EXPECT_EQ(table.row_scroll_position(200), 4030);
+  table.col_width(12, 5);
+  EXPECT_EQ(table.col_scroll_position(10), 800);
+  return true;
+}
+
+/* Test a table that is higher than the range of an int. */
+TEST(Fl_Table, huge_height) {
+  Ut_Size_Table table;
+  table.rows(100000000);
+  table.cols(1);
+  table.row_height_all(25);
+  EXPECT_TRUE(table.height() == 2500000000LL);
+  EXPECT_TRUE(table.row_scroll_position(90000000) == 2250000000LL);
+  // the scrollbar range is limited, the scroll position is not
+  EXPECT_TRUE(table.scrollbar_max() > 0 && table.scrollbar_max() <= 2147483647.0);
+  table.row_position(90000000);
+  EXPECT_EQ(table.top(), 90000000);
+  EXPECT_EQ(table.row_position(), 90000000);
+  table.row_position(99999999);
+  EXPECT_EQ(table.bottom(), 99999999);
+  int X, Y, W, H;
+  EXPECT_EQ(table.find_cell(Fl_Table::CONTEXT_CELL, 99999999, 0, X, Y, W, H), 0);
+  EXPECT_TRUE(Y > 0 && Y < 200);
+  EXPECT_EQ(H, 25);
+  table.row_position(0);
+  EXPECT_EQ(table.top(), 0);
+  return true;
+}
+
+class Ut_Row_Table : public Fl_Table_Row {
+public:
+  Ut_Row_Table() : Fl_Table_Row(0, 0, 200, 200) { end(); }
+  using Fl_Table::row_scroll_position;
+  long long height() const { return table_h; }
+};
+
+/* Test a table with many rows, a few of which have a different height,
+   and selecting and deselecting rows. */
+TEST(Fl_Table_Row, many_rows) {
+  Ut_Row_Table table;
+  table.rows(50000000);
+  table.row_height_all(10);
+  EXPECT_EQ(table.height(), 500000000);
+  table.row_height(7, 30);
+  table.row_height(8, 30);
+  table.row_height(40000000, 0);
+  EXPECT_EQ(table.row_height(8), 30);
+  EXPECT_EQ(table.row_height(9), 10);
+  EXPECT_EQ(table.row_scroll_position(9), 130);
+  EXPECT_EQ(table.row_scroll_position(40000001), 400000040);
+  EXPECT_EQ(table.height(), 500000030);
+  table.row_position(40000000);
+  EXPECT_EQ(table.row_position(), 40000000);
+  table.row_height(8, 10);
+  EXPECT_EQ(table.row_scroll_position(40000001), 400000020);
+  // compare the selection with a flag per row
+  const int n = 300;
+  char flags[n] = { 0 };
+  table.rows(n);
+  unsigned seed = 11;
+  for (int i = 0; i < 2000; i++) {
+    seed = seed * 1103515245 + 12345;
+    int row = (int)((seed >> 8) % n), flag = (int)((seed >> 4) % 3);
+    table.select_row(row, flag);
+    flags[row] = (flag == 2) ? !flags[row] : (char)flag;
+    if (i % 500 == 499) {
+      table.select_all_rows(2);
+      for (int r = 0; r < n; r++) flags[r] = !flags[r];
+    }
+  }
+  int same = 1;
+  for (int r = 0; r < n; r++)
+    if (table.row_selected(r) != flags[r]) same = 0;
+  EXPECT_TRUE(same);
+  // enumerate the selected ranges
+  int first, last, count = 0;
+  for (int r = 0; table.next_selected_range(r, first, last); r = last + 1) {
+    count += last - first + 1;
+  }
+  int expected = 0;
+  for (int r = 0; r < n; r++) expected += flags[r];
+  EXPECT_EQ(count, expected);
+  table.select_all_rows(0);
+  EXPECT_EQ(table.select_rows(250, 10, 1), 1);
+  EXPECT_EQ(table.select_rows(20, 30, 1), 0);
+  EXPECT_EQ(table.select_rows(100, 109, 0), 1);
+  EXPECT_EQ(table.select_rows(0, 19, 2), 1);
+  EXPECT_EQ(table.next_selected_range(0, first, last), 1);
+  EXPECT_EQ(first, 0);
+  EXPECT_EQ(last, 9);
+  EXPECT_EQ(table.next_selected_range(12, first, last), 1);
+  EXPECT_EQ(first, 20);
+  EXPECT_EQ(last, 99);
+  EXPECT_EQ(table.next_selected_range(105, first, last), 1);
+  EXPECT_EQ(first, 110);
+  EXPECT_EQ(last, 250);
+  EXPECT_EQ(table.next_selected_range(251, first, last), 0);
+  table.select_all_rows(1);
+  table.rows(n / 2);
+  table.rows(n);
+  EXPECT_EQ(table.row_selected(n / 2 - 1), 1);
+  EXPECT_EQ(table.row_selected(n / 2), 0);
+  table.type(Fl_Table_Row::SELECT_SINGLE);
+  EXPECT_EQ(table.row_selected(0), 1);
+  EXPECT_EQ(table.row_selected(1), 0);
+  table.select_row(5);
+  EXPECT_EQ(table.row_selected(0), 0);
+  EXPECT_EQ(table.row_selected(5), 1);
+  return true;
+}
+
+/* Test finding and adding tree items by path in large directories. */
+TEST(Fl_Tree, find_item) {
+  Fl_Tree tree(0, 0, 200, 200);
+  tree.end();
+  tree.sortorder(FL_TREE_SORT_ASCENDING);
+  char path[64];
+  for (int i = 0; i < 500; i++) {
+    int n = (i * 7919) % 500;
+    snprintf(path, sizeof(path), "dir%d/file%03d", n % 3, n);
+    EXPECT_TRUE(tree.add(path) != NULL);
+  }
+  Fl_Tree_Item *dir = tree.find_item("dir1");
+  EXPECT_TRUE(dir != NULL);
+  int sorted = 1;
+  for (int t = 1; t < dir->children(); t++)
+    if (strcmp(dir->child(t-1)->label(), dir->child(t)->label()) > 0) sorted = 0;
+  EXPECT_TRUE(sorted);
+  EXPECT_TRUE(tree.find_item("dir1/file004") != NULL);
+  EXPECT_TRUE(tree.find_item("dir1/file005") == NULL);
+  EXPECT_TRUE(tree.add("dir1/file004") == NULL);      // exists already
+  // duplicate labels find the first item
+  Fl_Tree_Item *a = dir->insert(tree.prefs(), "twin", 0);
+  Fl_Tree_Item *b = dir->insert(tree.prefs(), "twin", 5);
+  EXPECT_TRUE(dir->find_child_item("twin") == a);
+  EXPECT_EQ(dir->remove_child(a), 0);
+  EXPECT_TRUE(dir->find_child_item("twin") == b);
+  // renamed and removed items
+  Fl_Tree_Item *item = tree.find_item("dir1/file010");
+  item->label("renamed");
+  EXPECT_TRUE(tree.find_item("dir1/file010") == NULL);
+  EXPECT_TRUE(tree.find_item("dir1/renamed") == item);
+  EXPECT_EQ(tree.remove(item), 0);
+  EXPECT_TRUE(tree.find_item("dir1/renamed") == NULL);
+  EXPECT_EQ(dir->find_child("file013"), dir->find_child(tree.find_item("dir1/file013")));
+  return true;
+}
+
+/* A graphics driver with fixed font metrics that draws nothing. */
+class Ut_Measure_Driver : public Fl_Graphics_Driver {
+public:
+  void font(Fl_Font face, Fl_Fontsize fsize) override { font_ = face; size_ = fsize; }
+  Fl_Font font() override { return font_; }
+  double width(const char *, int n) override { return 8.0 * n; }
+  double width(unsigned int) override { return 8.0; }
+  int height() override { return size_ + 4; }
+  int descent() override { return 3; }
+  void draw(const char *, int, int, int) override { }
+  void draw(const char *, int, float, float) override { }
+  void rectf(int, int, int, int) override { }
+  void line(int, int, int, int) override { }
+  void point(int, int) override { }
+  void push_clip(int, int, int, int) override { }
+  void pop_clip() override { }
+};
+
+class Ut_Measure_Surface : public Fl_Surface_Device {
+public:
+  Ut_Measure_Surface(Fl_Graphics_Driver *d) : Fl_Surface_Device(d) { }
+};
+
+class Ut_Layout_Tree : public Fl_Tree {
+public:
+  Ut_Layout_Tree() : Fl_Tree(0, 0, 200, 200) { end(); }
+  void draw() override { Fl_Tree::draw(); }
+  int tree_h() const { return _tree_h; }
+  int tree_w() const { return _tree_w; }
+};
+
+/* Test the cached item sizes and the items that draw() skips. */
+TEST(Fl_Tree, layout) {
+  Ut_Measure_Driver driver;
+  Ut_Measure_Surface surface(&driver);
+  Fl_Surface_Device::push_current(&surface);
+  Ut_Layout_Tree tree;
+  char path[64];
+  for (int i = 0; i < 2000; i++) {
+    snprintf(path, sizeof(path), "dir%d/file%04d", i % 4, i);
+    tree.add(path);
+  }
+  tree.draw();
+  Fl_Tree_Item *dir = tree.find_item("dir2");
+  Fl_Tree_Item *item = tree.find_item("dir3/file1003");
+  dir->close();
+  dir->child(0)->label("a much longer label than any other");
+  tree.draw();
+  int h = tree.tree_h(), w = tree.tree_w();
+  tree.recalc_tree();                   // measure all items again
+  tree.calc_tree();
+  EXPECT_EQ(tree.tree_h(), h);
+  EXPECT_EQ(tree.tree_w(), w);
+  // the item was not laid out, but can be shown without a draw()
+  EXPECT_EQ(tree.displayed(item), 0);
+  tree.show_item_top(item);
+  EXPECT_EQ(tree.displayed(item), 1);
+  EXPECT_EQ(item->y(), tree.y());
+  // calc_tree() lays out the items on screen whose size is cached
+  Fl_Tree_Item *next = tree.next(item);
+  item->label("file1003 has a new label");
+  tree.calc_tree();
+  EXPECT_EQ(tree.displayed(next), 1);
+  Fl::e_x = next->x() + 1;
+  Fl::e_y = next->y() + 1;
+  EXPECT_TRUE(tree.find_clicked() == next);
+  tree.draw();
+  EXPECT_EQ(item->y(), tree.y());
+  EXPECT_EQ(tree.displayed(next), 1);
+  Fl_Surface_Device::pop_current();
+  return true;
+}
+
+class Ut_Browser : public Fl_Browser {
+public:
+  Ut_Browser() : Fl_Browser(0, 0, 200, 200) { end(); }
+  void draw() override { Fl_Browser::draw(); }
+  int full_height() const override { return Fl_Browser::full_height(); }
+  int full_width() const override { return Fl_Browser::full_width(); }
+  int width_of(int line) const { return item_width(find_line(line)); }
+  int position_of(int line) const { return item_position(find_line(line)); }
+  int line_at(int pos) const { int p; return lineno(item_at_position(pos, p)); }
+  int line_of(int line) const { return lineno(find_line(line)); }
+};
+
+/* Test finding lines by number and by position in a long browser. */
+TEST(Fl_Browser, many_lines) {
+  Ut_Measure_Driver driver;
+  Ut_Measure_Surface surface(&driver);
+  Fl_Surface_Device::push_current(&surface);
+  Ut_Browser b;
+  b.textsize(10);                       // every line is 14 pixels high
+  char text[32];
+  for (int i = 0; i < 10000; i++) {
+    snprintf(text, sizeof(text), "line %d", i);
+    if (i % 2) b.add(text);
+    else b.insert(1, text);             // even lines come first, in reverse order
+  }
+  EXPECT_STREQ(b.text(1), "line 9998");
+  EXPECT_STREQ(b.text(5000), "line 0");
+  EXPECT_STREQ(b.text(5001), "line 1");
+  EXPECT_EQ(b.line_of(7777), 7777);
+  EXPECT_EQ(b.full_height(), 10000 * 14);
+  b.remove(1);
+  b.move(1, 9999);
+  b.swap(2, 9998);
+  EXPECT_STREQ(b.text(1), "line 9999");
+  EXPECT_STREQ(b.text(2), "line 9995");
+  EXPECT_STREQ(b.text(9998), "line 9996");
+  EXPECT_EQ(b.size(), 9999);
+  // a taller and a hidden line move all lines after them
+  b.text(3, "@l3");
+  b.hide(4);
+  EXPECT_EQ(b.full_height(), 9999 * 14);
+  EXPECT_EQ(b.position_of(5), 2 * 14 + 28);
+  EXPECT_EQ(b.line_at(2 * 14 + 28), 5);
+  EXPECT_EQ(b.line_at(2 * 14 + 27), 3);
+  EXPECT_EQ(b.position_of(9999), 9998 * 14);
+  EXPECT_EQ(b.line_at(1000000), 9999);
+  b.show(4);
+  b.linespacing(1);
+  EXPECT_EQ(b.position_of(5), 3 * 14 + 28 + 4);
+  EXPECT_EQ(b.full_height(), 9999 * 15 + 14);
+  Fl_Surface_Device::pop_current();
+  return true;
+}
+
+/* Test the widest line after the widest lines are removed. */
+TEST(Fl_Browser, full_width) {
+  Ut_Measure_Driver driver;
+  Ut_Measure_Surface surface(&driver);
+  Fl_Surface_Device::push_current(&surface);
+  Ut_Browser b;
+  b.add("a very long line");
+  b.add("short");
+  b.add("a long line");
+  b.add("a long line");
+  int w1 = b.width_of(1), w3 = b.width_of(3), w2 = b.width_of(2);
+  b.draw();
+  EXPECT_EQ(b.full_width(), w1);
+  b.remove(1);                          // the next widest lines are known
+  EXPECT_EQ(b.full_width(), w3);
+  b.remove(2);
+  EXPECT_EQ(b.full_width(), w3);
+  b.remove(2);
+  EXPECT_EQ(b.full_width(), w2);
+  b.clear();
+  EXPECT_EQ(b.full_width(), 0);
+  Fl_Surface_Device::pop_current();
+  return true;
+}
+
+class Ut_File_Browser : public Fl_File_Browser {
+public:
+  Ut_File_Browser() : Fl_File_Browser(0, 0, 200, 200) { end(); }
+  int position_of(int line) const { return item_position(find_line(line)); }
+};
+
+/* Test that the cached line heights follow the icon size of Fl_File_Browser. */
+TEST(Fl_File_Browser, iconsize) {
+  Ut_Measure_Driver driver;
+  Ut_Measure_Surface surface(&driver);
+  Fl_Surface_Device::push_current(&surface);
+  Fl_File_Icon *icon = new Fl_File_Icon("*", Fl_File_Icon::PLAIN);
+  Ut_File_Browser b;
+  b.add("a");
+  b.add("b");
+  b.add("c");
+  // every line is as high as the icon plus 2 pixels
+  b.iconsize(40);
+  EXPECT_EQ(b.position_of(3), 2 * 42);
+  b.textsize(20);                       // the icon size is now 30
+  EXPECT_EQ(b.iconsize(), 30);
+  EXPECT_EQ(b.position_of(3), 2 * 32);
+  b.iconsize(50);
+  EXPECT_EQ(b.position_of(3), 2 * 52);
+  b.textsize(20);                       // same text size, icon size 30 again
+  EXPECT_EQ(b.position_of(3), 2 * 32);
+  delete icon;
+  Fl_Surface_Device::pop_current();
+  return true;
+}
+
+/* A graphics driver like Ut_Measure_Driver that records the text it draws. */
+class Ut_Record_Driver : public Ut_Measure_Driver {
+public:
+  std::vector<std::string> texts;
+  std::vector<int> xs;
+  void draw(const char *str, int n, int x, int) override {
+    texts.push_back(std::string(str, n));
+    xs.push_back(x);
+  }
+};
+
+class Ut_Draw_Terminal : public Fl_Terminal {
+public:
+  Ut_Draw_Terminal() : Fl_Terminal(0, 0, 400, 200) { end(); }
+  void draw_top_row() const { draw_row(disp_srow(), y()); }
+};
+
+/* Test that draw_row() draws runs of chars with the same style together. */
+TEST(Fl_Terminal, draw_row) {
+  Ut_Record_Driver driver;
+  Ut_Measure_Surface surface(&driver);
+  Fl_Surface_Device::push_current(&surface);
+  Ut_Draw_Terminal tty;
+  tty.textsize(14);                     // every char is 8 pixels wide
+  tty.append("hello world  \033[1mbold\033[0m \033[31mred\033[0m\n");
+  tty.draw_top_row();
+  EXPECT_EQ((int)driver.texts.size(), 3);
+  if (driver.texts.size() == 3) {
+    EXPECT_STREQ(driver.texts[0].c_str(), "hello world");
+    EXPECT_STREQ(driver.texts[1].c_str(), "bold");
+    EXPECT_STREQ(driver.texts[2].c_str(), "red");
+    EXPECT_EQ(driver.xs[1] - driver.xs[0], 13 * 8);
+    EXPECT_EQ(driver.xs[2] - driver.xs[0], 18 * 8);
+  }
+  Fl_Surface_Device::pop_current();
+  return true;
+}
+
+class Ut_Palette_Terminal : public Fl_Terminal {
+public:
+  Ut_Palette_Terminal() : Fl_Terminal(0, 0, 400, 200, 0, 5, 20, 100) { end(); }
+  int cell_size() const { return (int)sizeof(Utf8Char); }
+  Fl_Color fg_at(int drow, int dcol) const { return utf8_char_at_disp(drow, dcol)->fgcolor(); }
+  std::string text_at(int drow, int dcol) const {
+    const Utf8Char *u8c = utf8_char_at_disp(drow, dcol);
+    return std::string(u8c->text_utf8(), u8c->length());
+  }
+  Fl_Color bg_at(int drow, int dcol) const { return utf8_char_at_disp(drow, dcol)->bgcolor(); }
+  int cells() const { return ring_rows() * ring_cols(); }
+  Fl_Color fg_at_ring(int i) const { return u8c_ring_row(i / ring_cols())[i % ring_cols()].fgcolor(); }
+  static Fl_Color style_fg(Fl_Color fg) {
+    CharStyle style(true);              // not a style of any terminal
+    style.fgcolor(fg);
+    Utf8Char c;
+    c.text_ascii('x', style);
+    return c.fgcolor();
+  }
+};
+
+/* Test the palette of fg/bg color pairs of the chars in the terminal. */
+TEST(Fl_Terminal, palette) {
+  Ut_Palette_Terminal tty;
+  EXPECT_EQ(tty.cell_size(), 10);
+  tty.append("\033[38;2;1;2;3m\033[48;2;4;5;6mX\033[0m\n");
+  EXPECT_EQ(tty.fg_at(0, 0), (Fl_Color)0x01020300);
+  EXPECT_EQ(tty.bg_at(0, 0), (Fl_Color)0x04050600);
+  // Use more colors than a palette can hold, the unused ones are reused
+  char s[40];
+  int n = 70000;
+  for (int i = 0; i < n; i++) {
+    unsigned c = (unsigned)i * 7919u;
+    snprintf(s, sizeof(s), "\033[38;2;%u;%u;%umX",
+             (c >> 16) & 255, (c >> 8) & 255, c & 255);
+    tty.append(s);
+  }
+  int row = tty.cursor_row() - 1;     // the last 20 chars wrapped to this row
+  for (int col = 0; col < 20; col++) {
+    unsigned c = (unsigned)(n - 20 + col) * 7919u;
+    EXPECT_EQ(tty.fg_at(row, col), (Fl_Color)((c & 0xffffff) << 8));
+  }
+  // A style that was not made by a terminal keeps its colors, too
+  EXPECT_EQ(Ut_Palette_Terminal::style_fg(0x12345600), (Fl_Color)0x12345600);
+  return true;
+}
+
+/* Test that the terminal keeps the exact colors of more than 65536 pairs. */
+TEST(Fl_Terminal, palette_overflow) {
+  Ut_Palette_Terminal tty;
+  tty.history_rows(4000);               // room for 80000 chars
+  char s[40];
+  int n = 70000;
+  for (int i = 0; i < n; i++) {
+    snprintf(s, sizeof(s), "\033[38;2;%u;%u;%umX",
+             (i >> 16) & 255, (i >> 8) & 255, i & 255);
+    tty.append(s);
+  }
+  // every color is still in the ring
+  std::vector<bool> seen(n, false);
+  for (int i = 0; i < tty.cells(); i++) {
+    Fl_Color c = tty.fg_at_ring(i);
+    if ((c & 0xff) == 0 && (int)(c >> 8) < n) seen[c >> 8] = true;
+  }
+  int missing = 0;
+  for (int i = 1; i < n; i++)
+    if (!seen[i]) missing++;
+  EXPECT_EQ(missing, 0);
+  return true;
+}
+
+/* Test that append() prints runs of ASCII chars like single chars. */
+TEST(Fl_Terminal, append_runs) {
+  const char *text = "0123456789abcdefghijklmnopqrstuvwxyz\tx\033[31mred\033[0m\r\n"
+                     "ab\bc \xc3\xa4\xc3\xb6 01234567890123456789\n"
+                     "\033[2;3Hat\033[1mbold";
+  Ut_Palette_Terminal runs, chars;
+  runs.append(text);
+  for (const char *p = text; *p; p += fl_utf8len1(*p))
+    chars.print_char(p, fl_utf8len1(*p));
+  EXPECT_EQ(runs.cursor_row(), chars.cursor_row());
+  EXPECT_EQ(runs.cursor_col(), chars.cursor_col());
+  for (int row = 0; row < 5; row++) {
+    for (int col = 0; col < 20; col++) {
+      std::string run_text = runs.text_at(row, col), char_text = chars.text_at(row, col);
+      EXPECT_STREQ(run_text.c_str(), char_text.c_str());
+      EXPECT_EQ(runs.fg_at(row, col), chars.fg_at(row, col));
+    }
+  }
+  return true;
+}
+
 #if 0
 
 TEST(fl_filename, ext) {